@@ -0,0 +1,192 @@
+#pragma once
+
+#include "dijkstra_router.h"
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Finds several diverse routes between two vertices by the penalty method: after every
+// found route the weights of its edges grow, which pushes the next search onto other edges.
+// Routes are reported with their real weights, shortest first. Every search is a Dijkstra
+// over the frozen graph, so the cost is a few single-pair queries and no preprocessing.
+// Edges' weights should be non-negative, as every routing engine already checks.
+template <typename Weight>
+class AlternativeRoutesFinder {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RoutingEngine<Weight>::RouteInfo;
+    using Clock = std::chrono::steady_clock;
+    // Decides whether a found alternative may be reported, rejected ones are penalized all the same.
+    // The shortest route is always reported
+    using RouteFilter = std::function<bool(const RouteInfo&)>;
+
+    struct Settings {
+        size_t max_route_count = 3;
+        // An edge's weight grows by this share for every found route that used it
+        double penalty = 0.5;
+        // Routes more than this times longer than the shortest one are not reported
+        double max_stretch = 1.5;
+        // Searches per reported route, to give up when no more diverse routes exist
+        size_t max_searches_per_route = 3;
+    };
+
+    explicit AlternativeRoutesFinder(const Graph& graph);
+
+    // The shortest route is always searched to the end; the following searches stop at the deadline
+    std::vector<RouteInfo> FindRoutes(VertexId from, VertexId to, const Settings& settings,
+                                      Clock::time_point deadline, const RouteFilter& filter = {}) const;
+
+private:
+    // Penalty counts of all edges, reset after every query through the list of touched edges
+    struct Penalties {
+        std::vector<uint32_t> use_counts;
+        std::vector<EdgeId> touched_edges;
+    };
+
+    static SearchScratch<Weight>& GetScratch() {
+        thread_local SearchScratch<Weight> scratch;
+        return scratch;
+    }
+    static Penalties& GetPenalties() {
+        thread_local Penalties penalties;
+        return penalties;
+    }
+
+    std::optional<std::vector<EdgeId>> FindPenalizedRoute(VertexId from, VertexId to, const Penalties& penalties,
+                                                          double penalty, std::optional<Clock::time_point> deadline) const;
+
+    // The clock is read once per this many settled vertices
+    static constexpr size_t DEADLINE_CHECK_PERIOD = 1024;
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr EdgeId NO_EDGE = SearchScratch<Weight>::NO_EDGE;
+    const Graph& graph_;
+};
+
+template <typename Weight>
+AlternativeRoutesFinder<Weight>::AlternativeRoutesFinder(const Graph& graph)
+    : graph_(graph)
+{
+    if (!graph.IsFrozen()) {
+        throw std::invalid_argument("Graph should be frozen");
+    }
+}
+
+template <typename Weight>
+std::vector<typename AlternativeRoutesFinder<Weight>::RouteInfo> AlternativeRoutesFinder<Weight>::FindRoutes(
+    VertexId from, VertexId to, const Settings& settings, Clock::time_point deadline, const RouteFilter& filter) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex is out of graph");
+    }
+
+    Penalties& penalties = GetPenalties();
+    if (penalties.use_counts.size() < graph_.GetEdgeCount()) {
+        penalties.use_counts.resize(graph_.GetEdgeCount(), 0);
+    }
+
+    std::vector<RouteInfo> routes;
+    const size_t max_search_count = settings.max_route_count * settings.max_searches_per_route;
+    for (size_t search = 0; search < max_search_count && routes.size() < settings.max_route_count; ++search) {
+        if (search > 0 && Clock::now() >= deadline) {
+            break;
+        }
+        auto edges = FindPenalizedRoute(from, to, penalties, settings.penalty,
+                                        search > 0 ? std::optional<Clock::time_point>(deadline) : std::nullopt);
+        if (!edges) {
+            break;
+        }
+
+        Weight weight = ZERO_WEIGHT;
+        for (const EdgeId edge_id : *edges) {
+            weight += graph_.GetEdge(edge_id).weight;
+            if (penalties.use_counts[edge_id]++ == 0) {
+                penalties.touched_edges.push_back(edge_id);
+            }
+        }
+        if (routes.empty()) {
+            routes.push_back({weight, std::move(*edges)});
+            continue;
+        }
+        const bool is_new = std::none_of(routes.begin(), routes.end(), [&](const RouteInfo& route) {
+            return route.edges == *edges;
+        });
+        // The first search finds the shortest route, which bounds all the others
+        const bool is_short = weight <= routes.front().weight * settings.max_stretch;
+        RouteInfo route{weight, std::move(*edges)};
+        if (is_new && is_short && (!filter || filter(route))) {
+            routes.push_back(std::move(route));
+        }
+    }
+
+    for (const EdgeId edge_id : penalties.touched_edges) {
+        penalties.use_counts[edge_id] = 0;
+    }
+    penalties.touched_edges.clear();
+
+    std::sort(routes.begin(), routes.end(), [](const RouteInfo& lhs, const RouteInfo& rhs) {
+        return lhs.weight < rhs.weight;
+    });
+    return routes;
+}
+
+template <typename Weight>
+std::optional<std::vector<EdgeId>> AlternativeRoutesFinder<Weight>::FindPenalizedRoute(
+    VertexId from, VertexId to, const Penalties& penalties, double penalty,
+    std::optional<Clock::time_point> deadline) const {
+    SearchScratch<Weight>& scratch = GetScratch();
+    scratch.Prepare(graph_.GetVertexCount());
+
+    scratch.Reach(from, ZERO_WEIGHT, NO_EDGE);
+    scratch.Push(ZERO_WEIGHT, from);
+    size_t settled_count = 0;
+    while (!scratch.queue.empty()) {
+        const auto [vertex_weight, vertex] = scratch.Pop();
+        if (vertex_weight > scratch.weight[vertex]) {
+            continue;
+        }
+        if (vertex == to) {
+            break;
+        }
+        if (deadline && ++settled_count % DEADLINE_CHECK_PERIOD == 0 && Clock::now() >= *deadline) {
+            return std::nullopt;
+        }
+        const auto outgoing_edges = graph_.GetOutgoingEdges(vertex);
+        for (size_t i = 0; i < outgoing_edges.count; ++i) {
+            const VertexId next = outgoing_edges.targets[i];
+            const uint32_t use_count = penalties.use_counts[outgoing_edges.edge_ids[i]];
+            const Weight edge_weight = use_count == 0 ? outgoing_edges.weights[i]
+                                                      : outgoing_edges.weights[i] * (1 + penalty * use_count);
+            const Weight candidate_weight = vertex_weight + edge_weight;
+            if (!scratch.IsReached(next) || candidate_weight < scratch.weight[next]) {
+                scratch.Reach(next, candidate_weight, outgoing_edges.edge_ids[i]);
+                scratch.Push(candidate_weight, next);
+            }
+        }
+    }
+
+    if (!scratch.IsReached(to)) {
+        return std::nullopt;
+    }
+    std::vector<EdgeId> edges;
+    for (EdgeId edge_id = scratch.prev_edge[to]; edge_id != NO_EDGE;
+         edge_id = scratch.prev_edge[graph_.GetEdge(edge_id).from])
+    {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+    return edges;
+}
+
+}  // namespace graph
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "dijkstra_router.h"
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Bidirectional A*: a forward search from the start and a backward search from the finish,
+// both steered towards each other by a lower bound of the remaining weight.
+// Needs no preprocessing, the backward search walks the frozen graph's incoming edges.
+//
+// The bound must be consistent: bound(u, t) <= weight(u, v) + bound(v, t) and
+// bound(s, v) <= bound(s, u) + weight(u, v) for every edge (u, v), which holds for
+// any metric scaled to never exceed edge weights. Both searches use the average
+// potential p(v) = (bound(v, to) - bound(from, v)) / 2, so the reduced weights stay
+// non-negative in both directions and the usual bidirectional stop rule applies.
+template <typename Weight>
+class AStarRouter final : public RoutingEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RoutingEngine<Weight>::RouteInfo;
+    // Lower bound of the weight of any path from the first vertex to the second one
+    using LowerBound = std::function<Weight(VertexId, VertexId)>;
+
+    AStarRouter(const Graph& graph, LowerBound lower_bound);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+private:
+    static SearchScratch<Weight>& GetScratch(bool is_backward) {
+        thread_local SearchScratch<Weight> scratches[2];
+        return scratches[is_backward ? 1 : 0];
+    }
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr EdgeId NO_EDGE = SearchScratch<Weight>::NO_EDGE;
+    const Graph& graph_;
+    LowerBound lower_bound_;
+};
+
+template <typename Weight>
+AStarRouter<Weight>::AStarRouter(const Graph& graph, LowerBound lower_bound)
+    : graph_(graph)
+    , lower_bound_(std::move(lower_bound))
+{
+    if (!graph.IsFrozen()) {
+        throw std::invalid_argument("Graph should be frozen");
+    }
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename AStarRouter<Weight>::RouteInfo> AStarRouter<Weight>::BuildRoute(VertexId from,
+                                                                                       VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex is out of graph");
+    }
+
+    const auto potential = [&](VertexId vertex) {
+        return (lower_bound_(vertex, to) - lower_bound_(from, vertex)) / 2;
+    };
+
+    // Queue keys are weight + potential forward and weight - potential backward,
+    // so a meeting at v has forward key + backward key equal to the path weight
+    SearchScratch<Weight>& forward = GetScratch(false);
+    SearchScratch<Weight>& backward = GetScratch(true);
+    forward.Prepare(vertex_count);
+    backward.Prepare(vertex_count);
+    forward.Reach(from, ZERO_WEIGHT, NO_EDGE);
+    forward.Push(potential(from), from);
+    backward.Reach(to, ZERO_WEIGHT, NO_EDGE);
+    backward.Push(-potential(to), to);
+
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+    const auto update_best = [&](VertexId vertex) {
+        if (forward.IsReached(vertex) && backward.IsReached(vertex)) {
+            const Weight weight = forward.weight[vertex] + backward.weight[vertex];
+            if (!best_weight || weight < *best_weight) {
+                best_weight = weight;
+                meeting_vertex = vertex;
+            }
+        }
+    };
+    update_best(from);
+
+    const auto step = [&](SearchScratch<Weight>& scratch, bool is_backward) {
+        const VertexId vertex = scratch.Pop().second;
+        const Weight vertex_weight = scratch.weight[vertex];
+        const auto relax = [&](VertexId next, Weight edge_weight, EdgeId edge_id) {
+            const Weight candidate_weight = vertex_weight + edge_weight;
+            if (!scratch.IsReached(next) || candidate_weight < scratch.weight[next]) {
+                scratch.Reach(next, candidate_weight, edge_id);
+                scratch.Push(candidate_weight + (is_backward ? -potential(next) : potential(next)), next);
+                update_best(next);
+            }
+        };
+        if (is_backward) {
+            const auto incoming_edges = graph_.GetIncomingEdges(vertex);
+            for (size_t i = 0; i < incoming_edges.count; ++i) {
+                relax(incoming_edges.sources[i], incoming_edges.weights[i], incoming_edges.edge_ids[i]);
+            }
+        } else {
+            const auto outgoing_edges = graph_.GetOutgoingEdges(vertex);
+            for (size_t i = 0; i < outgoing_edges.count; ++i) {
+                relax(outgoing_edges.targets[i], outgoing_edges.weights[i], outgoing_edges.edge_ids[i]);
+            }
+        }
+    };
+    // Stale queue items only lower the minimum key, which keeps the stop rule conservative
+    while (!forward.queue.empty() && !backward.queue.empty()) {
+        const Weight forward_key = forward.queue.front().first;
+        const Weight backward_key = backward.queue.front().first;
+        if (best_weight && forward_key + backward_key >= *best_weight) {
+            break;
+        }
+        step(backward_key < forward_key ? backward : forward, backward_key < forward_key);
+    }
+
+    if (!best_weight) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> edges;
+    for (EdgeId edge_id = forward.prev_edge[meeting_vertex]; edge_id != NO_EDGE;
+         edge_id = forward.prev_edge[graph_.GetEdge(edge_id).from]) {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+    for (EdgeId edge_id = backward.prev_edge[meeting_vertex]; edge_id != NO_EDGE;
+         edge_id = backward.prev_edge[graph_.GetEdge(edge_id).to]) {
+        edges.push_back(edge_id);
+    }
+
+    Weight weight = ZERO_WEIGHT;
+    for (const EdgeId edge_id : edges) {
+        weight += graph_.GetEdge(edge_id).weight;
+    }
+    return RouteInfo{weight, std::move(edges)};
+}
+
+}  // namespace graph
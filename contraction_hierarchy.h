@@ -0,0 +1,546 @@
+#pragma once
+
+#include "dijkstra_router.h"
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Contraction Hierarchies: vertices are contracted one by one in order of importance,
+// and a shortcut is added wherever contraction would break a shortest path.
+// A query is a bidirectional Dijkstra that only goes up the hierarchy and touches a
+// small part of the graph. Memory stays close to linear in the graph size.
+//
+// Ids of hierarchy edges: [0, edge count) are the graph's own edges, the following
+// ones are shortcuts. Every shortcut is made of two hierarchy edges and unpacks back
+// to the graph's edges.
+template <typename Weight>
+class ContractionHierarchy final : public RoutingEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RoutingEngine<Weight>::RouteInfo;
+
+    struct Shortcut {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        EdgeId first;
+        EdgeId second;
+    };
+
+    struct Hierarchy {
+        std::vector<uint32_t> ranks;
+        std::vector<Shortcut> shortcuts;
+    };
+
+    explicit ContractionHierarchy(const Graph& graph);
+    // Restores the engine from a previously built hierarchy, skipping preprocessing
+    ContractionHierarchy(const Graph& graph, Hierarchy hierarchy);
+    // Customizes the hierarchy for other weights of the same edges: contracts the graph in the
+    // order given by ranks of a hierarchy built before. Only shortcuts are recomputed, the old
+    // order stays good as long as the weights change moderately
+    ContractionHierarchy(const Graph& graph, const std::vector<uint32_t>& ranks);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    const Hierarchy& GetHierarchy() const;
+
+private:
+    // Bounds the witness search run for every pair of neighbours of a contracted vertex.
+    // A search that gives up early only costs an unnecessary shortcut. Priorities are
+    // only estimates, so they are computed with a cheaper search.
+    static constexpr size_t WITNESS_SETTLED_LIMIT = 500;
+    static constexpr size_t PRIORITY_SETTLED_LIMIT = 50;
+    // Contraction in a known order trades a few more shortcuts for a much shorter search
+    static constexpr size_t CUSTOMIZATION_WITNESS_SETTLED_LIMIT = 100;
+
+    struct Neighbour {
+        VertexId vertex;
+        Weight weight;
+        EdgeId edge;
+    };
+
+    VertexId GetFrom(EdgeId edge_id) const {
+        const size_t edge_count = graph_.GetEdgeCount();
+        return edge_id < edge_count ? graph_.GetEdge(edge_id).from : hierarchy_.shortcuts[edge_id - edge_count].from;
+    }
+    VertexId GetTo(EdgeId edge_id) const {
+        const size_t edge_count = graph_.GetEdgeCount();
+        return edge_id < edge_count ? graph_.GetEdge(edge_id).to : hierarchy_.shortcuts[edge_id - edge_count].to;
+    }
+    Weight GetWeight(EdgeId edge_id) const {
+        const size_t edge_count = graph_.GetEdgeCount();
+        return edge_id < edge_count ? graph_.GetEdge(edge_id).weight : hierarchy_.shortcuts[edge_id - edge_count].weight;
+    }
+
+    // Incidence lists of the graph being contracted, shortcuts included
+    struct ContractionState {
+        std::vector<std::vector<EdgeId>> outgoing_edges;
+        std::vector<std::vector<EdgeId>> incoming_edges;
+        std::vector<bool> is_contracted;
+        std::vector<int> contracted_neighbours;
+        SearchScratch<Weight> scratch;
+        uint32_t next_rank = 0;
+    };
+
+    void CheckWeights() const;
+    ContractionState MakeContractionState() const;
+    void Contract();
+    void ContractInOrder(const std::vector<uint32_t>& ranks);
+    // Adds the shortcuts the vertex needs, marks it contracted and gives it the next rank
+    void ContractVertex(VertexId vertex, ContractionState& state, size_t settled_limit);
+    std::vector<Neighbour> CollectNeighbours(const std::vector<std::vector<EdgeId>>& incident_edges, VertexId vertex,
+                                             const std::vector<bool>& is_contracted, bool is_outgoing) const;
+    std::vector<Shortcut> FindShortcuts(VertexId vertex, const std::vector<std::vector<EdgeId>>& outgoing_edges,
+                                        const std::vector<std::vector<EdgeId>>& incoming_edges,
+                                        const std::vector<bool>& is_contracted, SearchScratch<Weight>& scratch,
+                                        size_t settled_limit) const;
+    void BuildUpwardEdges();
+    void UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const;
+
+    static SearchScratch<Weight>& GetScratch(bool is_backward) {
+        thread_local SearchScratch<Weight> scratches[2];
+        return scratches[is_backward ? 1 : 0];
+    }
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr EdgeId NO_EDGE = SearchScratch<Weight>::NO_EDGE;
+    const Graph& graph_;
+    Hierarchy hierarchy_;
+    // Edges leading to higher ranked vertices, compressed by vertex: forward ones by their
+    // start, backward ones by their end. The other end and the weight are stored next to
+    // the edge id, so a query never looks edges up
+    struct UpwardEdges {
+        std::vector<size_t> offsets;
+        std::vector<uint32_t> heads;
+        std::vector<Weight> weights;
+        std::vector<EdgeId> edge_ids;
+    };
+    UpwardEdges forward_;
+    UpwardEdges backward_;
+};
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph)
+    : graph_(graph)
+{
+    CheckWeights();
+    Contract();
+    BuildUpwardEdges();
+}
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph, Hierarchy hierarchy)
+    : graph_(graph)
+    , hierarchy_(std::move(hierarchy))
+{
+    if (hierarchy_.ranks.size() != graph.GetVertexCount()) {
+        throw std::invalid_argument("Contraction hierarchy does not match the graph");
+    }
+    const size_t vertex_count = graph.GetVertexCount();
+    std::vector<bool> is_rank_used(vertex_count, false);
+    for (const uint32_t rank : hierarchy_.ranks) {
+        if (rank >= vertex_count || is_rank_used[rank]) {
+            throw std::invalid_argument("Ranks of a contraction hierarchy should be a permutation");
+        }
+        is_rank_used[rank] = true;
+    }
+    // A shortcut only ever joins edges built before it, otherwise UnpackEdge would never finish
+    size_t known_edge_count = graph.GetEdgeCount();
+    for (const Shortcut& shortcut : hierarchy_.shortcuts) {
+        if (shortcut.from >= vertex_count || shortcut.to >= vertex_count
+            || shortcut.first >= known_edge_count || shortcut.second >= known_edge_count) {
+            throw std::invalid_argument("Contraction hierarchy does not match the graph");
+        }
+        ++known_edge_count;
+    }
+    BuildUpwardEdges();
+}
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph, const std::vector<uint32_t>& ranks)
+    : graph_(graph)
+{
+    if (ranks.size() != graph.GetVertexCount()) {
+        throw std::invalid_argument("Contraction hierarchy does not match the graph");
+    }
+    CheckWeights();
+    ContractInOrder(ranks);
+    BuildUpwardEdges();
+}
+
+template <typename Weight>
+const typename ContractionHierarchy<Weight>::Hierarchy& ContractionHierarchy<Weight>::GetHierarchy() const {
+    return hierarchy_;
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::CheckWeights() const {
+    for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        if (graph_.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+std::vector<typename ContractionHierarchy<Weight>::Neighbour> ContractionHierarchy<Weight>::CollectNeighbours(
+    const std::vector<std::vector<EdgeId>>& incident_edges, VertexId vertex, const std::vector<bool>& is_contracted,
+    bool is_outgoing) const {
+    std::vector<Neighbour> neighbours;
+    for (const EdgeId edge_id : incident_edges[vertex]) {
+        const VertexId neighbour = is_outgoing ? GetTo(edge_id) : GetFrom(edge_id);
+        if (neighbour != vertex && !is_contracted[neighbour]) {
+            neighbours.push_back({neighbour, GetWeight(edge_id), edge_id});
+        }
+    }
+    // Only the lightest of parallel edges matters
+    std::sort(neighbours.begin(), neighbours.end(), [](const Neighbour& lhs, const Neighbour& rhs) {
+        return std::pair{lhs.vertex, lhs.weight} < std::pair{rhs.vertex, rhs.weight};
+    });
+    neighbours.erase(std::unique(neighbours.begin(), neighbours.end(),
+                                 [](const Neighbour& lhs, const Neighbour& rhs) { return lhs.vertex == rhs.vertex; }),
+                     neighbours.end());
+    return neighbours;
+}
+
+template <typename Weight>
+std::vector<typename ContractionHierarchy<Weight>::Shortcut> ContractionHierarchy<Weight>::FindShortcuts(
+    VertexId vertex, const std::vector<std::vector<EdgeId>>& outgoing_edges,
+    const std::vector<std::vector<EdgeId>>& incoming_edges, const std::vector<bool>& is_contracted,
+    SearchScratch<Weight>& scratch, size_t settled_limit) const {
+    std::vector<Shortcut> shortcuts;
+    const auto sources = CollectNeighbours(incoming_edges, vertex, is_contracted, false);
+    const auto targets = CollectNeighbours(outgoing_edges, vertex, is_contracted, true);
+    if (sources.empty() || targets.empty()) {
+        return shortcuts;
+    }
+    Weight max_target_weight = ZERO_WEIGHT;
+    for (const Neighbour& target : targets) {
+        max_target_weight = std::max(max_target_weight, target.weight);
+    }
+
+    for (const Neighbour& source : sources) {
+        // Witness search: shortest paths from the source that avoid the contracted vertex
+        const Weight weight_limit = source.weight + max_target_weight;
+        scratch.Prepare(graph_.GetVertexCount());
+        scratch.Reach(source.vertex, ZERO_WEIGHT, NO_EDGE);
+        scratch.Push(ZERO_WEIGHT, source.vertex);
+        size_t settled_count = 0;
+        size_t unsettled_target_count = targets.size();
+        while (!scratch.queue.empty() && settled_count < settled_limit && unsettled_target_count > 0) {
+            const auto [current_weight, current] = scratch.Pop();
+            if (current_weight > scratch.weight[current]) {
+                continue;
+            }
+            if (current_weight > weight_limit) {
+                break;
+            }
+            ++settled_count;
+            if (std::binary_search(targets.begin(), targets.end(), Neighbour{current, ZERO_WEIGHT, NO_EDGE},
+                                   [](const Neighbour& lhs, const Neighbour& rhs) { return lhs.vertex < rhs.vertex; })) {
+                --unsettled_target_count;
+            }
+            for (const EdgeId edge_id : outgoing_edges[current]) {
+                const VertexId next = GetTo(edge_id);
+                if (next == vertex || is_contracted[next]) {
+                    continue;
+                }
+                const Weight candidate_weight = current_weight + GetWeight(edge_id);
+                if (!scratch.IsReached(next) || candidate_weight < scratch.weight[next]) {
+                    scratch.Reach(next, candidate_weight, edge_id);
+                    scratch.Push(candidate_weight, next);
+                }
+            }
+        }
+
+        for (const Neighbour& target : targets) {
+            if (target.vertex == source.vertex) {
+                continue;
+            }
+            const Weight through_weight = source.weight + target.weight;
+            if (scratch.IsReached(target.vertex) && scratch.weight[target.vertex] <= through_weight) {
+                continue;
+            }
+            shortcuts.push_back({source.vertex, target.vertex, through_weight, source.edge, target.edge});
+        }
+    }
+    return shortcuts;
+}
+
+template <typename Weight>
+typename ContractionHierarchy<Weight>::ContractionState ContractionHierarchy<Weight>::MakeContractionState() const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    ContractionState state;
+    state.outgoing_edges.resize(vertex_count);
+    state.incoming_edges.resize(vertex_count);
+    for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        if (edge.from != edge.to) {
+            state.outgoing_edges[edge.from].push_back(edge_id);
+            state.incoming_edges[edge.to].push_back(edge_id);
+        }
+    }
+    state.is_contracted.assign(vertex_count, false);
+    state.contracted_neighbours.assign(vertex_count, 0);
+    return state;
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::Contract() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    ContractionState state = MakeContractionState();
+
+    // Edge difference plus the number of already contracted neighbours keeps the
+    // hierarchy flat and spreads contraction evenly over the graph
+    const auto compute_priority = [&](VertexId vertex) {
+        const int shortcut_count = static_cast<int>(FindShortcuts(vertex, state.outgoing_edges, state.incoming_edges,
+                                                                  state.is_contracted, state.scratch,
+                                                                  PRIORITY_SETTLED_LIMIT).size());
+        const int removed_count = static_cast<int>(
+            CollectNeighbours(state.incoming_edges, vertex, state.is_contracted, false).size()
+            + CollectNeighbours(state.outgoing_edges, vertex, state.is_contracted, true).size());
+        return shortcut_count - removed_count + state.contracted_neighbours[vertex];
+    };
+
+    using QueueItem = std::pair<int, VertexId>;
+    std::vector<QueueItem> queue;
+    queue.reserve(vertex_count);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        queue.push_back({compute_priority(vertex), vertex});
+    }
+    std::make_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+
+    hierarchy_.ranks.assign(vertex_count, 0);
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+        const VertexId vertex = queue.back().second;
+        queue.pop_back();
+
+        // Lazy update: priorities of neighbours change as the graph is contracted
+        const int priority = compute_priority(vertex);
+        if (!queue.empty() && priority > queue.front().first) {
+            queue.push_back({priority, vertex});
+            std::push_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+            continue;
+        }
+        ContractVertex(vertex, state, WITNESS_SETTLED_LIMIT);
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::ContractInOrder(const std::vector<uint32_t>& ranks) {
+    const size_t vertex_count = graph_.GetVertexCount();
+    std::vector<VertexId> order(vertex_count, vertex_count);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        if (ranks[vertex] >= vertex_count || order[ranks[vertex]] != vertex_count) {
+            throw std::invalid_argument("Ranks of a contraction hierarchy should be a permutation");
+        }
+        order[ranks[vertex]] = vertex;
+    }
+
+    ContractionState state = MakeContractionState();
+    hierarchy_.ranks.assign(vertex_count, 0);
+    for (const VertexId vertex : order) {
+        ContractVertex(vertex, state, CUSTOMIZATION_WITNESS_SETTLED_LIMIT);
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::ContractVertex(VertexId vertex, ContractionState& state, size_t settled_limit) {
+    auto& outgoing_edges = state.outgoing_edges;
+    auto& incoming_edges = state.incoming_edges;
+    auto& is_contracted = state.is_contracted;
+    for (Shortcut& shortcut : FindShortcuts(vertex, outgoing_edges, incoming_edges, is_contracted, state.scratch,
+                                            settled_limit)) {
+        // A parallel edge that is not heavier makes the shortcut useless
+        const auto& parallel_edges = outgoing_edges[shortcut.from];
+        if (std::any_of(parallel_edges.begin(), parallel_edges.end(), [&](EdgeId edge_id) {
+                return GetTo(edge_id) == shortcut.to && GetWeight(edge_id) <= shortcut.weight;
+            })) {
+            continue;
+        }
+        const EdgeId edge_id = graph_.GetEdgeCount() + hierarchy_.shortcuts.size();
+        outgoing_edges[shortcut.from].push_back(edge_id);
+        incoming_edges[shortcut.to].push_back(edge_id);
+        hierarchy_.shortcuts.push_back(std::move(shortcut));
+    }
+    is_contracted[vertex] = true;
+    // Edges of contracted vertices are never looked at again, so they are dropped
+    // from the neighbours' lists to keep witness searches short
+    const auto drop_contracted = [&](std::vector<EdgeId>& edges, bool is_outgoing) {
+        edges.erase(std::remove_if(edges.begin(), edges.end(), [&](EdgeId edge_id) {
+                        return is_contracted[is_outgoing ? GetTo(edge_id) : GetFrom(edge_id)];
+                    }),
+                    edges.end());
+    };
+    for (const EdgeId edge_id : outgoing_edges[vertex]) {
+        const VertexId neighbour = GetTo(edge_id);
+        ++state.contracted_neighbours[neighbour];
+        drop_contracted(incoming_edges[neighbour], false);
+    }
+    for (const EdgeId edge_id : incoming_edges[vertex]) {
+        const VertexId neighbour = GetFrom(edge_id);
+        ++state.contracted_neighbours[neighbour];
+        drop_contracted(outgoing_edges[neighbour], true);
+    }
+    hierarchy_.ranks[vertex] = state.next_rank++;
+    outgoing_edges[vertex].clear();
+    outgoing_edges[vertex].shrink_to_fit();
+    incoming_edges[vertex].clear();
+    incoming_edges[vertex].shrink_to_fit();
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::BuildUpwardEdges() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    const size_t hierarchy_edge_count = graph_.GetEdgeCount() + hierarchy_.shortcuts.size();
+    forward_.offsets.assign(vertex_count + 1, 0);
+    backward_.offsets.assign(vertex_count + 1, 0);
+
+    const auto for_each_upward_edge = [&](const auto& callback) {
+        for (EdgeId edge_id = 0; edge_id < hierarchy_edge_count; ++edge_id) {
+            const VertexId from = GetFrom(edge_id);
+            const VertexId to = GetTo(edge_id);
+            if (from == to) {
+                continue;
+            }
+            const bool is_forward = hierarchy_.ranks[from] < hierarchy_.ranks[to];
+            callback(edge_id, is_forward, is_forward ? from : to);
+        }
+    };
+    for_each_upward_edge([&](EdgeId, bool is_forward, VertexId vertex) {
+        ++(is_forward ? forward_ : backward_).offsets[vertex + 1];
+    });
+    for (UpwardEdges* upward_edges : {&forward_, &backward_}) {
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            upward_edges->offsets[vertex + 1] += upward_edges->offsets[vertex];
+        }
+        upward_edges->heads.resize(upward_edges->offsets.back());
+        upward_edges->weights.resize(upward_edges->offsets.back());
+        upward_edges->edge_ids.resize(upward_edges->offsets.back());
+    }
+    std::vector<size_t> forward_positions(forward_.offsets.begin(), forward_.offsets.end() - 1);
+    std::vector<size_t> backward_positions(backward_.offsets.begin(), backward_.offsets.end() - 1);
+    for_each_upward_edge([&](EdgeId edge_id, bool is_forward, VertexId vertex) {
+        UpwardEdges& upward_edges = is_forward ? forward_ : backward_;
+        const size_t position = (is_forward ? forward_positions : backward_positions)[vertex]++;
+        upward_edges.heads[position] = static_cast<uint32_t>(is_forward ? GetTo(edge_id) : GetFrom(edge_id));
+        upward_edges.weights[position] = GetWeight(edge_id);
+        upward_edges.edge_ids[position] = edge_id;
+    });
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const {
+    std::vector<EdgeId> stack{edge_id};
+    while (!stack.empty()) {
+        const EdgeId current = stack.back();
+        stack.pop_back();
+        if (current < graph_.GetEdgeCount()) {
+            edges.push_back(current);
+            continue;
+        }
+        const Shortcut& shortcut = hierarchy_.shortcuts[current - graph_.GetEdgeCount()];
+        stack.push_back(shortcut.second);
+        stack.push_back(shortcut.first);
+    }
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchy<Weight>::RouteInfo> ContractionHierarchy<Weight>::BuildRoute(
+    VertexId from, VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex is out of graph");
+    }
+
+    SearchScratch<Weight>& forward = GetScratch(false);
+    SearchScratch<Weight>& backward = GetScratch(true);
+    forward.Prepare(vertex_count);
+    backward.Prepare(vertex_count);
+    forward.Reach(from, ZERO_WEIGHT, NO_EDGE);
+    forward.Push(ZERO_WEIGHT, from);
+    backward.Reach(to, ZERO_WEIGHT, NO_EDGE);
+    backward.Push(ZERO_WEIGHT, to);
+
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+    const auto update_best = [&](VertexId vertex) {
+        if (forward.IsReached(vertex) && backward.IsReached(vertex)) {
+            const Weight weight = forward.weight[vertex] + backward.weight[vertex];
+            if (!best_weight || weight < *best_weight) {
+                best_weight = weight;
+                meeting_vertex = vertex;
+            }
+        }
+    };
+    update_best(from);
+
+    // Each direction stops once its queue cannot improve the best meeting found so far
+    const auto step = [&](SearchScratch<Weight>& scratch, const UpwardEdges& upward_edges) {
+        const auto [vertex_weight, vertex] = scratch.Pop();
+        if (vertex_weight > scratch.weight[vertex]) {
+            return;
+        }
+        if (best_weight && vertex_weight >= *best_weight) {
+            scratch.queue.clear();
+            return;
+        }
+        for (size_t i = upward_edges.offsets[vertex]; i < upward_edges.offsets[vertex + 1]; ++i) {
+            const VertexId next = upward_edges.heads[i];
+            const Weight candidate_weight = vertex_weight + upward_edges.weights[i];
+            if (!scratch.IsReached(next) || candidate_weight < scratch.weight[next]) {
+                scratch.Reach(next, candidate_weight, upward_edges.edge_ids[i]);
+                scratch.Push(candidate_weight, next);
+                update_best(next);
+            }
+        }
+    };
+    while (!forward.queue.empty() || !backward.queue.empty()) {
+        const bool is_backward = forward.queue.empty()
+            || (!backward.queue.empty() && backward.queue.front().first < forward.queue.front().first);
+        if (is_backward) {
+            step(backward, backward_);
+        } else {
+            step(forward, forward_);
+        }
+    }
+
+    if (!best_weight) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> upward_path;
+    for (EdgeId edge_id = forward.prev_edge[meeting_vertex]; edge_id != NO_EDGE;
+         edge_id = forward.prev_edge[GetFrom(edge_id)]) {
+        upward_path.push_back(edge_id);
+    }
+    std::reverse(upward_path.begin(), upward_path.end());
+    for (EdgeId edge_id = backward.prev_edge[meeting_vertex]; edge_id != NO_EDGE;
+         edge_id = backward.prev_edge[GetTo(edge_id)]) {
+        upward_path.push_back(edge_id);
+    }
+
+    std::vector<EdgeId> edges;
+    Weight weight = ZERO_WEIGHT;
+    for (const EdgeId edge_id : upward_path) {
+        UnpackEdge(edge_id, edges);
+    }
+    for (const EdgeId edge_id : edges) {
+        weight += graph_.GetEdge(edge_id).weight;
+    }
+    return RouteInfo{weight, std::move(edges)};
+}
+
+}  // namespace graph
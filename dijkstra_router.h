@@ -0,0 +1,408 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Buffers of one Dijkstra search, reused between queries. A vertex's weight and
+// predecessor are valid only if its stamp equals the current search stamp,
+// so nothing has to be cleared between searches.
+template <typename Weight>
+struct SearchScratch {
+    using QueueItem = std::pair<Weight, VertexId>;
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+    std::vector<Weight> weight;
+    std::vector<EdgeId> prev_edge;
+    std::vector<uint32_t> stamp;
+    std::vector<QueueItem> queue;
+    uint32_t current_stamp = 0;
+
+    void Prepare(size_t vertex_count) {
+        if (stamp.size() < vertex_count) {
+            weight.resize(vertex_count);
+            prev_edge.resize(vertex_count);
+            stamp.resize(vertex_count, 0);
+        }
+        queue.clear();
+        if (++current_stamp == 0) {
+            std::fill(stamp.begin(), stamp.end(), 0);
+            current_stamp = 1;
+        }
+    }
+    bool IsReached(VertexId vertex) const {
+        return stamp[vertex] == current_stamp;
+    }
+    void Reach(VertexId vertex, Weight vertex_weight, EdgeId edge_id) {
+        stamp[vertex] = current_stamp;
+        weight[vertex] = vertex_weight;
+        prev_edge[vertex] = edge_id;
+    }
+    void Push(Weight vertex_weight, VertexId vertex) {
+        queue.push_back({vertex_weight, vertex});
+        std::push_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+    }
+    QueueItem Pop() {
+        std::pop_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+        const QueueItem item = queue.back();
+        queue.pop_back();
+        return item;
+    }
+};
+
+// Answers every query with a binary-heap Dijkstra search over the frozen graph itself.
+// Keeps no per-pair data, so memory stays linear in the graph size.
+template <typename Weight>
+class DijkstraRouter final : public RoutingEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RoutingEngine<Weight>::RouteInfo;
+
+    explicit DijkstraRouter(const Graph& graph);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+private:
+    static SearchScratch<Weight>& GetScratch() {
+        thread_local SearchScratch<Weight> scratch;
+        return scratch;
+    }
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr EdgeId NO_EDGE = SearchScratch<Weight>::NO_EDGE;
+    const Graph& graph_;
+};
+
+template <typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+    : graph_(graph)
+{
+    if (!graph.IsFrozen()) {
+        throw std::invalid_argument("Graph should be frozen");
+    }
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+                                                                                             VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex is out of graph");
+    }
+
+    SearchScratch<Weight>& scratch = GetScratch();
+    scratch.Prepare(vertex_count);
+
+    scratch.Reach(from, ZERO_WEIGHT, NO_EDGE);
+    scratch.Push(ZERO_WEIGHT, from);
+    while (!scratch.queue.empty()) {
+        const auto [vertex_weight, vertex] = scratch.Pop();
+        if (vertex_weight > scratch.weight[vertex]) {
+            continue;
+        }
+        if (vertex == to) {
+            break;
+        }
+        const auto outgoing_edges = graph_.GetOutgoingEdges(vertex);
+        for (size_t i = 0; i < outgoing_edges.count; ++i) {
+            const VertexId next = outgoing_edges.targets[i];
+            const Weight candidate_weight = vertex_weight + outgoing_edges.weights[i];
+            if (!scratch.IsReached(next) || candidate_weight < scratch.weight[next]) {
+                scratch.Reach(next, candidate_weight, outgoing_edges.edge_ids[i]);
+                scratch.Push(candidate_weight, next);
+            }
+        }
+    }
+
+    if (!scratch.IsReached(to)) {
+        return std::nullopt;
+    }
+    std::vector<EdgeId> edges;
+    for (EdgeId edge_id = scratch.prev_edge[to]; edge_id != NO_EDGE;
+         edge_id = scratch.prev_edge[graph_.GetEdge(edge_id).from])
+    {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{scratch.weight[to], std::move(edges)};
+}
+
+// Vertex a route may start or end at and the weight the route gets for starting or ending there
+template <typename Weight>
+struct WeightedVertex {
+    VertexId vertex;
+    Weight weight;
+};
+
+// Route between two sets of vertices: the indexes of its source and target and the route itself,
+// whose weight does not include theirs
+template <typename Weight>
+struct RouteBetweenSets {
+    size_t source_index;
+    size_t target_index;
+    typename RoutingEngine<Weight>::RouteInfo route;
+};
+
+// Shortest route from one of the sources to one of the targets, counting their weights, found by a single
+// Dijkstra search started from all the sources at once. Weights of the targets should be non-negative:
+// the search stops once no vertex left is closer than the best route found
+template <typename Weight>
+std::optional<RouteBetweenSets<Weight>> BuildRouteBetweenSets(const DirectedWeightedGraph<Weight>& graph,
+                                                              const std::vector<WeightedVertex<Weight>>& sources,
+                                                              const std::vector<WeightedVertex<Weight>>& targets) {
+    if (!graph.IsFrozen()) {
+        throw std::invalid_argument("Graph should be frozen");
+    }
+    const size_t vertex_count = graph.GetVertexCount();
+    std::vector<bool> is_target(vertex_count, false);
+    for (const auto& target : targets) {
+        if (target.vertex >= vertex_count) {
+            throw std::out_of_range("Vertex is out of graph");
+        }
+        is_target[target.vertex] = true;
+    }
+
+    constexpr EdgeId NO_EDGE = SearchScratch<Weight>::NO_EDGE;
+    SearchScratch<Weight> scratch;
+    scratch.Prepare(vertex_count);
+    for (const auto& source : sources) {
+        if (source.vertex >= vertex_count) {
+            throw std::out_of_range("Vertex is out of graph");
+        }
+        if (!scratch.IsReached(source.vertex) || source.weight < scratch.weight[source.vertex]) {
+            scratch.Reach(source.vertex, source.weight, NO_EDGE);
+            scratch.Push(source.weight, source.vertex);
+        }
+    }
+
+    std::optional<size_t> best_target;
+    Weight best_weight{};
+    while (!scratch.queue.empty()) {
+        const auto [vertex_weight, vertex] = scratch.Pop();
+        if (vertex_weight > scratch.weight[vertex]) {
+            continue;
+        }
+        if (best_target && !(vertex_weight < best_weight)) {
+            break;
+        }
+        if (is_target[vertex]) {
+            for (size_t i = 0; i < targets.size(); ++i) {
+                if (targets[i].vertex == vertex && (!best_target || vertex_weight + targets[i].weight < best_weight)) {
+                    best_target = i;
+                    best_weight = vertex_weight + targets[i].weight;
+                }
+            }
+        }
+        const auto outgoing_edges = graph.GetOutgoingEdges(vertex);
+        for (size_t i = 0; i < outgoing_edges.count; ++i) {
+            const VertexId next = outgoing_edges.targets[i];
+            const Weight candidate_weight = vertex_weight + outgoing_edges.weights[i];
+            if (!scratch.IsReached(next) || candidate_weight < scratch.weight[next]) {
+                scratch.Reach(next, candidate_weight, outgoing_edges.edge_ids[i]);
+                scratch.Push(candidate_weight, next);
+            }
+        }
+    }
+    if (!best_target) {
+        return std::nullopt;
+    }
+
+    // The route is summed over its edges, the weight of a vertex includes the weight of its source
+    typename RoutingEngine<Weight>::RouteInfo route{Weight{}, {}};
+    VertexId from = targets[*best_target].vertex;
+    for (EdgeId edge_id = scratch.prev_edge[from]; edge_id != NO_EDGE; edge_id = scratch.prev_edge[from]) {
+        route.edges.push_back(edge_id);
+        route.weight += graph.GetEdge(edge_id).weight;
+        from = graph.GetEdge(edge_id).from;
+    }
+    std::reverse(route.edges.begin(), route.edges.end());
+    size_t source_index = 0;
+    while (sources[source_index].vertex != from || sources[source_index].weight != scratch.weight[from]) {
+        ++source_index;
+    }
+    return RouteBetweenSets<Weight>{source_index, *best_target, std::move(route)};
+}
+
+// Shortest paths between one root vertex and many others, found by a single Dijkstra
+// search: forward from the root, or backward into it over incoming edges.
+// With targets given the search stops once all of them are settled, and only their
+// routes are known; with no targets the whole reachable part of the graph is settled.
+// With max_weight given no vertex farther than it is reached, so the search never leaves
+// the ball of that radius around the root.
+template <typename Weight>
+class ShortestPathTree {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RoutingEngine<Weight>::RouteInfo;
+
+    enum class Direction {
+        FORWARD,
+        BACKWARD,
+    };
+
+    ShortestPathTree(const Graph& graph, VertexId root, Direction direction = Direction::FORWARD,
+                     const std::vector<VertexId>& targets = {}, std::optional<Weight> max_weight = std::nullopt);
+
+    VertexId GetRoot() const;
+    // Vertices with a known route, in order of their weights
+    const std::vector<VertexId>& GetSettledVertices() const;
+    // Route from the root to the vertex for a forward tree, from the vertex to the root for a backward one
+    std::optional<Weight> GetWeight(VertexId vertex) const;
+    // Edge of the route adjacent to the vertex: the last one forward, the first one backward.
+    // Empty for the root and for vertices without a known route
+    std::optional<EdgeId> GetLastEdge(VertexId vertex) const;
+    std::optional<RouteInfo> BuildRoute(VertexId vertex) const;
+
+private:
+    void CheckVertex(VertexId vertex) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr EdgeId NO_EDGE = SearchScratch<Weight>::NO_EDGE;
+    const Graph& graph_;
+    VertexId root_;
+    Direction direction_;
+    SearchScratch<Weight> scratch_;
+    std::vector<bool> is_settled_;
+    std::vector<VertexId> settled_vertices_;
+};
+
+template <typename Weight>
+ShortestPathTree<Weight>::ShortestPathTree(const Graph& graph, VertexId root, Direction direction,
+                                           const std::vector<VertexId>& targets, std::optional<Weight> max_weight)
+    : graph_(graph)
+    , root_(root)
+    , direction_(direction)
+    , is_settled_(graph.GetVertexCount(), false)
+{
+    if (!graph.IsFrozen()) {
+        throw std::invalid_argument("Graph should be frozen");
+    }
+    CheckVertex(root);
+
+    const size_t vertex_count = graph_.GetVertexCount();
+    std::vector<bool> is_target(targets.empty() ? 0 : vertex_count, false);
+    size_t unsettled_target_count = 0;
+    for (const VertexId target : targets) {
+        CheckVertex(target);
+        if (!is_target[target]) {
+            is_target[target] = true;
+            ++unsettled_target_count;
+        }
+    }
+
+    scratch_.Prepare(vertex_count);
+    scratch_.Reach(root, ZERO_WEIGHT, NO_EDGE);
+    scratch_.Push(ZERO_WEIGHT, root);
+    const auto relax = [&](VertexId next, Weight candidate_weight, EdgeId edge_id) {
+        if (max_weight && candidate_weight > *max_weight) {
+            return;
+        }
+        if (!scratch_.IsReached(next) || candidate_weight < scratch_.weight[next]) {
+            scratch_.Reach(next, candidate_weight, edge_id);
+            scratch_.Push(candidate_weight, next);
+        }
+    };
+    while (!scratch_.queue.empty()) {
+        const auto [vertex_weight, vertex] = scratch_.Pop();
+        if (is_settled_[vertex]) {
+            continue;
+        }
+        is_settled_[vertex] = true;
+        settled_vertices_.push_back(vertex);
+        if (!targets.empty() && is_target[vertex] && --unsettled_target_count == 0) {
+            break;
+        }
+        if (direction_ == Direction::FORWARD) {
+            const auto outgoing_edges = graph_.GetOutgoingEdges(vertex);
+            for (size_t i = 0; i < outgoing_edges.count; ++i) {
+                relax(outgoing_edges.targets[i], vertex_weight + outgoing_edges.weights[i], outgoing_edges.edge_ids[i]);
+            }
+        } else {
+            const auto incoming_edges = graph_.GetIncomingEdges(vertex);
+            for (size_t i = 0; i < incoming_edges.count; ++i) {
+                relax(incoming_edges.sources[i], vertex_weight + incoming_edges.weights[i], incoming_edges.edge_ids[i]);
+            }
+        }
+    }
+}
+
+template <typename Weight>
+VertexId ShortestPathTree<Weight>::GetRoot() const {
+    return root_;
+}
+
+template <typename Weight>
+const std::vector<VertexId>& ShortestPathTree<Weight>::GetSettledVertices() const {
+    return settled_vertices_;
+}
+
+template <typename Weight>
+std::optional<Weight> ShortestPathTree<Weight>::GetWeight(VertexId vertex) const {
+    CheckVertex(vertex);
+    if (!is_settled_[vertex]) {
+        return std::nullopt;
+    }
+    return scratch_.weight[vertex];
+}
+
+template <typename Weight>
+std::optional<EdgeId> ShortestPathTree<Weight>::GetLastEdge(VertexId vertex) const {
+    CheckVertex(vertex);
+    if (!is_settled_[vertex] || scratch_.prev_edge[vertex] == NO_EDGE) {
+        return std::nullopt;
+    }
+    return scratch_.prev_edge[vertex];
+}
+
+template <typename Weight>
+std::optional<typename ShortestPathTree<Weight>::RouteInfo> ShortestPathTree<Weight>::BuildRoute(VertexId vertex) const {
+    CheckVertex(vertex);
+    if (!is_settled_[vertex]) {
+        return std::nullopt;
+    }
+    std::vector<EdgeId> edges;
+    if (direction_ == Direction::FORWARD) {
+        for (EdgeId edge_id = scratch_.prev_edge[vertex]; edge_id != NO_EDGE;
+             edge_id = scratch_.prev_edge[graph_.GetEdge(edge_id).from])
+        {
+            edges.push_back(edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+    } else {
+        for (EdgeId edge_id = scratch_.prev_edge[vertex]; edge_id != NO_EDGE;
+             edge_id = scratch_.prev_edge[graph_.GetEdge(edge_id).to])
+        {
+            edges.push_back(edge_id);
+        }
+    }
+    return RouteInfo{scratch_.weight[vertex], std::move(edges)};
+}
+
+template <typename Weight>
+void ShortestPathTree<Weight>::CheckVertex(VertexId vertex) const {
+    if (vertex >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex is out of graph");
+    }
+}
+
+}  // namespace graph
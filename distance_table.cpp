@@ -0,0 +1,81 @@
+#include "distance_table.h"
+
+#include <algorithm>
+
+namespace transport_catalogue {
+	namespace data_base {
+		void DistanceTable::Set(uint32_t from_stop, uint32_t to_stop, int distance)
+		{
+			if ((used_slot_count_ + 1) * 2 > slots_.size()) {
+				Grow();
+			}
+			const uint64_t key = MakeKey(from_stop, to_stop);
+			Slot& slot = slots_[FindSlot(key)];
+			if (slot.key == EMPTY_KEY) {
+				slot.key = key;
+				++used_slot_count_;
+			}
+			int& slot_distance = from_stop <= to_stop ? slot.forward : slot.backward;
+			if (slot_distance == NO_DISTANCE) {
+				++size_;
+			}
+			slot_distance = distance;
+		}
+
+		int DistanceTable::Find(uint32_t from_stop, uint32_t to_stop) const
+		{
+			if (slots_.empty()) {
+				return 0;
+			}
+			const Slot& slot = slots_[FindSlot(MakeKey(from_stop, to_stop))];
+			if (slot.key == EMPTY_KEY) {
+				return 0;
+			}
+			const int direct = from_stop <= to_stop ? slot.forward : slot.backward;
+			const int reverse = from_stop <= to_stop ? slot.backward : slot.forward;
+			if (direct != NO_DISTANCE) {
+				return direct;
+			}
+			return reverse != NO_DISTANCE ? reverse : 0;
+		}
+
+		size_t DistanceTable::GetSize() const
+		{
+			return size_;
+		}
+
+		uint64_t DistanceTable::MakeKey(uint32_t from_stop, uint32_t to_stop)
+		{
+			return (static_cast<uint64_t>(std::min(from_stop, to_stop)) << 32) | std::max(from_stop, to_stop);
+		}
+
+		uint64_t DistanceTable::Mix(uint64_t key)
+		{
+			// Finalizer of splitmix64
+			key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ull;
+			key = (key ^ (key >> 27)) * 0x94D049BB133111EBull;
+			return key ^ (key >> 31);
+		}
+
+		size_t DistanceTable::FindSlot(uint64_t key) const
+		{
+			const size_t mask = slots_.size() - 1;
+			size_t index = Mix(key) & mask;
+			while (slots_[index].key != key && slots_[index].key != EMPTY_KEY) {
+				index = (index + 1) & mask;
+			}
+			return index;
+		}
+
+		void DistanceTable::Grow()
+		{
+			std::vector<Slot> slots(std::max(MIN_CAPACITY, slots_.size() * 2));
+			std::swap(slots, slots_);
+			for (const Slot& slot : slots) {
+				if (slot.key != EMPTY_KEY) {
+					slots_[FindSlot(slot.key)] = slot;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace transport_catalogue {
+	namespace data_base {
+		// Road distances between stops in an open-addressing table with linear probing.
+		// Both directions of a pair of stops share one slot, keyed by the pair with the smaller id first,
+		// so a distance missing in one direction is found in the other one by the same probe sequence
+		class DistanceTable {
+		public:
+			void Set(uint32_t from_stop, uint32_t to_stop, int distance);
+			// Distance in the given direction, otherwise in the reverse one, otherwise 0
+			int Find(uint32_t from_stop, uint32_t to_stop) const;
+			// Number of distances set, each direction counts on its own
+			size_t GetSize() const;
+			// Calls action(from_stop, to_stop, distance) for every distance set
+			template <typename Action>
+			void ForEach(Action action) const;
+
+		private:
+			static constexpr uint64_t EMPTY_KEY = std::numeric_limits<uint64_t>::max();
+			static constexpr int NO_DISTANCE = std::numeric_limits<int>::min();
+			static constexpr size_t MIN_CAPACITY = 16;
+
+			struct Slot
+			{
+				uint64_t key = EMPTY_KEY;
+				// From the smaller id to the larger one and back
+				int forward = NO_DISTANCE;
+				int backward = NO_DISTANCE;
+			};
+
+			static uint64_t MakeKey(uint32_t from_stop, uint32_t to_stop);
+			// Keys of neighbouring stops differ in few low bits, so they are mixed before probing
+			static uint64_t Mix(uint64_t key);
+			// Slot holding the key or the empty slot where it belongs
+			size_t FindSlot(uint64_t key) const;
+			void Grow();
+
+			// The capacity is a power of two and at most half of the slots are used
+			std::vector<Slot> slots_;
+			size_t used_slot_count_ = 0;
+			size_t size_ = 0;
+		};
+
+		template <typename Action>
+		void DistanceTable::ForEach(Action action) const
+		{
+			for (const Slot& slot : slots_) {
+				if (slot.key == EMPTY_KEY) {
+					continue;
+				}
+				const uint32_t first = static_cast<uint32_t>(slot.key >> 32);
+				const uint32_t second = static_cast<uint32_t>(slot.key);
+				if (slot.forward != NO_DISTANCE) {
+					action(first, second, slot.forward);
+				}
+				if (slot.backward != NO_DISTANCE) {
+					action(second, first, slot.backward);
+				}
+			}
+		}
+	}
+}
@@ -1,10 +1,12 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <vector>
-#include <set>
 #include <optional>
 
+#include "ranges.h"
+
 namespace transport_catalogue {
 	namespace data_base {
 		enum class ReserchStatus
@@ -19,18 +21,28 @@ namespace transport_catalogue {
 			TWO_DIRECTIONAL
 		};
 
-		struct Stop
+		// Statistics of a bus route, computed once when the bus is added
+		struct BusStats
 		{
-			std::string name;
-			double latitude;
-			double longitude;
+			int stops_count{};
+			int unique_stops_count{};
+			// Great-circle length of the route in meters
+			double route_length{};
+			// Road length of the route in meters
+			int way{};
 		};
 
 		struct Bus {
 			std::string name;
-			std::vector<Stop*> stops;
+			// Catalogue ids of the stops in the order the bus passes them
+			std::vector<uint32_t> stops;
 			RouteType type = RouteType::CIRCLE;
-			std::optional<Stop*> second_final_stop{};
+			std::optional<uint32_t> second_final_stop{};
+			// Road and great-circle distances in meters from the first stop to each stop of the route,
+			// so the length of any part of the route is a difference of two of them
+			std::vector<int> road_distances;
+			std::vector<double> geo_distances;
+			BusStats stats{};
 		};
 
 		struct BusInfo {
@@ -44,11 +56,19 @@ namespace transport_catalogue {
 			BusInfo() = default;
 		};
 
+		// Stop found near a point and the great-circle distance to it in meters
+		struct NearbyStop
+		{
+			std::string_view stop_name{};
+			double distance{};
+		};
+
 		struct StopInfo
 		{
 			ReserchStatus status = ReserchStatus::NOT_FOUND;
 			std::string_view stop_name{};
-			std::set<std::string_view> buses{};
+			// Ids of the buses passing the stop in the order of their names, a view of the catalogue's storage
+			ranges::Range<const uint32_t*> buses{ nullptr, nullptr };
 
 			StopInfo() = default;
 		};
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define GRAPH_FLOYD_WARSHALL_AVX2
+#endif
+
+namespace graph {
+namespace floyd_warshall {
+
+// Min-plus relaxation of one row segment through one intermediate vertex:
+//     if (weight_from + weights_through[j] < weights[j])
+//         weights[j] = weight_from + weights_through[j],
+//         prev_edges[j] = prev_edges_through[j] != no_edge ? prev_edges_through[j] : prev_edge_from;
+// Missing routes must hold an infinite weight, then they never win a comparison.
+// Every implementation does exactly the same IEEE operations, so results do not depend on which one runs.
+template <typename Weight, typename StoredWeight>
+void RelaxRowScalar(StoredWeight* weights, uint32_t* prev_edges, Weight weight_from, uint32_t prev_edge_from,
+                    const StoredWeight* weights_through, const uint32_t* prev_edges_through, size_t count,
+                    uint32_t no_edge) {
+    for (size_t j = 0; j < count; ++j) {
+        const Weight candidate_weight = weight_from + weights_through[j];
+        if (candidate_weight < weights[j]) {
+            weights[j] = static_cast<StoredWeight>(candidate_weight);
+            prev_edges[j] = prev_edges_through[j] != no_edge ? prev_edges_through[j] : prev_edge_from;
+        }
+    }
+}
+
+#ifdef GRAPH_FLOYD_WARSHALL_AVX2
+__attribute__((target("avx2")))
+inline void RelaxRowAvx2(double* weights, uint32_t* prev_edges, double weight_from, uint32_t prev_edge_from,
+                         const double* weights_through, const uint32_t* prev_edges_through, size_t count,
+                         uint32_t no_edge) {
+    const __m256d from = _mm256_set1_pd(weight_from);
+    const __m128i prev_from = _mm_set1_epi32(static_cast<int>(prev_edge_from));
+    const __m128i no_prev = _mm_set1_epi32(static_cast<int>(no_edge));
+    const __m256i even_lanes = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    size_t j = 0;
+    for (; j + 4 <= count; j += 4) {
+        const __m256d candidate = _mm256_add_pd(from, _mm256_loadu_pd(weights_through + j));
+        const __m256d current = _mm256_loadu_pd(weights + j);
+        const __m256d less = _mm256_cmp_pd(candidate, current, _CMP_LT_OQ);
+        if (_mm256_movemask_pd(less) == 0) {
+            continue;
+        }
+        _mm256_storeu_pd(weights + j, _mm256_blendv_pd(current, candidate, less));
+
+        const __m128i less_32 = _mm256_castsi256_si128(
+            _mm256_permutevar8x32_epi32(_mm256_castpd_si256(less), even_lanes));
+        const __m128i prev_through = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_edges_through + j));
+        const __m128i prev_candidate = _mm_blendv_epi8(prev_through, prev_from, _mm_cmpeq_epi32(prev_through, no_prev));
+        const __m128i prev_current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_edges + j));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(prev_edges + j), _mm_blendv_epi8(prev_current, prev_candidate, less_32));
+    }
+    RelaxRowScalar<double, double>(weights + j, prev_edges + j, weight_from, prev_edge_from,
+                                   weights_through + j, prev_edges_through + j, count - j, no_edge);
+}
+
+inline bool HasAvx2() {
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+}
+#endif
+
+template <typename Weight, typename StoredWeight>
+void RelaxRow(StoredWeight* weights, uint32_t* prev_edges, Weight weight_from, uint32_t prev_edge_from,
+              const StoredWeight* weights_through, const uint32_t* prev_edges_through, size_t count,
+              uint32_t no_edge) {
+#ifdef GRAPH_FLOYD_WARSHALL_AVX2
+    if constexpr (std::is_same_v<Weight, double> && std::is_same_v<StoredWeight, double>) {
+        if (HasAvx2()) {
+            RelaxRowAvx2(weights, prev_edges, weight_from, prev_edge_from, weights_through, prev_edges_through,
+                         count, no_edge);
+            return;
+        }
+    }
+#endif
+    RelaxRowScalar(weights, prev_edges, weight_from, prev_edge_from, weights_through, prev_edges_through, count,
+                   no_edge);
+}
+
+// Runs task(0) ... task(task_count - 1) on up to thread_count threads
+template <typename Task>
+void ParallelFor(size_t task_count, size_t thread_count, const Task& task) {
+    thread_count = std::min(std::max<size_t>(thread_count, 1), task_count);
+    if (thread_count <= 1) {
+        for (size_t i = 0; i < task_count; ++i) {
+            task(i);
+        }
+        return;
+    }
+    std::atomic<size_t> next_task{0};
+    const auto worker = [&] {
+        for (size_t i = next_task++; i < task_count; i = next_task++) {
+            task(i);
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    for (size_t i = 0; i + 1 < thread_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// Blocked Floyd-Warshall over a row-major vertex_count x vertex_count table.
+// For every block of intermediate vertices K it relaxes the diagonal block first,
+// then the blocks of row K and column K in parallel, then all other blocks in parallel.
+//
+// Plain blocked Floyd-Warshall changes the association of floating point sums.
+// To stay bit-identical to the one-vertex-at-a-time pass, the value of (i, k) and
+// (k, j) is snapshotted at the step k is processed, and later phases read the
+// snapshots instead of the table, so every cell sees the same operands in the same order.
+template <typename Weight, typename StoredWeight>
+void RunBlocked(StoredWeight* weights, uint32_t* prev_edges, size_t vertex_count, uint32_t no_route,
+                uint32_t no_edge, size_t thread_count, size_t block_size) {
+    static_assert(std::is_floating_point_v<StoredWeight>, "Blocked pass needs infinite weights for missing routes");
+    if (vertex_count == 0) {
+        return;
+    }
+    constexpr size_t STRIP_WIDTH = 1024;
+    block_size = std::clamp<size_t>(block_size, 1, vertex_count);
+    const size_t block_count = (vertex_count + block_size - 1) / block_size;
+
+    // column_* is vertex_count x block_size: (i, k) at step k; row_* is block_size x vertex_count: (k, j) at step k
+    std::vector<StoredWeight> column_weights(vertex_count * block_size);
+    std::vector<uint32_t> column_prev_edges(vertex_count * block_size);
+    std::vector<StoredWeight> row_weights(block_size * vertex_count);
+    std::vector<uint32_t> row_prev_edges(block_size * vertex_count);
+
+    const auto block_begin = [&](size_t block) { return block * block_size; };
+    const auto block_end = [&](size_t block) { return std::min(vertex_count, (block + 1) * block_size); };
+
+    // Relaxes row i over columns [begin, end) through the snapshotted step k
+    const auto relax = [&](size_t i, size_t k_index, size_t begin, size_t end) {
+        const size_t column_cell = i * block_size + k_index;
+        if (column_prev_edges[column_cell] == no_route) {
+            return;
+        }
+        RelaxRow<Weight, StoredWeight>(weights + i * vertex_count + begin, prev_edges + i * vertex_count + begin,
+                                       column_weights[column_cell], column_prev_edges[column_cell],
+                                       row_weights.data() + k_index * vertex_count + begin,
+                                       row_prev_edges.data() + k_index * vertex_count + begin, end - begin, no_edge);
+    };
+    const auto snapshot_column = [&](size_t i, size_t k) {
+        column_weights[i * block_size + (k % block_size)] = weights[i * vertex_count + k];
+        column_prev_edges[i * block_size + (k % block_size)] = prev_edges[i * vertex_count + k];
+    };
+    const auto snapshot_row = [&](size_t k, size_t begin, size_t end) {
+        std::copy(weights + k * vertex_count + begin, weights + k * vertex_count + end,
+                  row_weights.begin() + (k % block_size) * vertex_count + begin);
+        std::copy(prev_edges + k * vertex_count + begin, prev_edges + k * vertex_count + end,
+                  row_prev_edges.begin() + (k % block_size) * vertex_count + begin);
+    };
+
+    for (size_t block_k = 0; block_k < block_count; ++block_k) {
+        const size_t k_begin = block_begin(block_k);
+        const size_t k_end = block_end(block_k);
+
+        // Phase 1: diagonal block
+        for (size_t k = k_begin; k < k_end; ++k) {
+            snapshot_row(k, k_begin, k_end);
+            for (size_t i = k_begin; i < k_end; ++i) {
+                snapshot_column(i, k);
+                relax(i, k - k_begin, k_begin, k_end);
+            }
+        }
+
+        // Phase 2: blocks of row K (tasks [0, block_count)) and column K (tasks [block_count, 2 * block_count))
+        ParallelFor(2 * block_count, thread_count, [&](size_t task) {
+            const bool is_row = task < block_count;
+            const size_t block = is_row ? task : task - block_count;
+            if (block == block_k) {
+                return;
+            }
+            const size_t begin = block_begin(block);
+            const size_t end = block_end(block);
+            for (size_t k = k_begin; k < k_end; ++k) {
+                if (is_row) {
+                    snapshot_row(k, begin, end);
+                    for (size_t i = k_begin; i < k_end; ++i) {
+                        relax(i, k - k_begin, begin, end);
+                    }
+                } else {
+                    for (size_t i = begin; i < end; ++i) {
+                        snapshot_column(i, k);
+                        relax(i, k - k_begin, k_begin, k_end);
+                    }
+                }
+            }
+        });
+
+        // Phase 3: remaining blocks, one task per block row. Columns are swept in wide
+        // strips: the snapshotted rows of K stay in cache while each table row is read once
+        ParallelFor(block_count, thread_count, [&](size_t block_i) {
+            if (block_i == block_k) {
+                return;
+            }
+            for (size_t strip_begin = 0; strip_begin < vertex_count; strip_begin += STRIP_WIDTH) {
+                const size_t strip_end = std::min(vertex_count, strip_begin + STRIP_WIDTH);
+                for (size_t i = block_begin(block_i); i < block_end(block_i); ++i) {
+                    for (size_t k = k_begin; k < k_end; ++k) {
+                        if (strip_begin < k_begin) {
+                            relax(i, k - k_begin, strip_begin, std::min(strip_end, k_begin));
+                        }
+                        if (strip_end > k_end) {
+                            relax(i, k - k_begin, std::max(strip_begin, k_end), strip_end);
+                        }
+                    }
+                }
+            }
+        });
+    }
+}
+
+}  // namespace floyd_warshall
+}  // namespace graph
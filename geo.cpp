@@ -1,20 +1,66 @@
 #define _USE_MATH_DEFINES
 #include "geo.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace geo {
 
-double ComputeDistance(Coordinates from, Coordinates to) {
+namespace {
+
+const double DEGREES_TO_RADIANS = M_PI / 180.;
+
+// The spherical law of cosines over the sines and cosines of both latitudes.
+// Every distance is computed here, so batches and single pairs agree exactly
+inline double ComputeDistance(double from_lng, double from_sin, double from_cos,
+                              double to_lng, double to_sin, double to_cos) {
     using namespace std;
+    // Rounding may push the cosine of two very close points just above 1
+    return acos(min(1., from_sin * to_sin + from_cos * to_cos * cos(abs(from_lng - to_lng) * DEGREES_TO_RADIANS)))
+        * EARTH_RADIUS;
+}
+
+}  // namespace
+
+double ComputeDistance(Coordinates from, Coordinates to) {
     if (from == to) {
         return 0;
     }
-    double earth_radius = 6371000;
-    static const double dr = M_PI / 180.;
-    return acos(sin(from.lat * dr) * sin(to.lat * dr)
-                + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
-        * earth_radius;
+    return ComputeDistance(from.lng, ComputeLatitudeSine(from.lat), ComputeLatitudeCosine(from.lat),
+                           to.lng, ComputeLatitudeSine(to.lat), ComputeLatitudeCosine(to.lat));
+}
+
+double ComputeLatitudeSine(double latitude) {
+    return std::sin(latitude * DEGREES_TO_RADIANS);
+}
+
+double ComputeLatitudeCosine(double latitude) {
+    return std::cos(latitude * DEGREES_TO_RADIANS);
+}
+
+double ComputeDistance(const PointColumns& points, uint32_t from, uint32_t to) {
+    if (points.latitudes[from] == points.latitudes[to] && points.longitudes[from] == points.longitudes[to]) {
+        return 0;
+    }
+    return ComputeDistance(points.longitudes[from], points.latitude_sines[from], points.latitude_cosines[from],
+                           points.longitudes[to], points.latitude_sines[to], points.latitude_cosines[to]);
+}
+
+void ComputeDistances(const PointColumns& points, const uint32_t* from, const uint32_t* to, size_t count, double* distances) {
+    for (size_t i = 0; i < count; ++i) {
+        distances[i] = ComputeDistance(points, from[i], to[i]);
+    }
+}
+
+void ComputeDistances(Coordinates point, const PointColumns& points, const uint32_t* ids, size_t count, double* distances) {
+    const double point_sin = ComputeLatitudeSine(point.lat);
+    const double point_cos = ComputeLatitudeCosine(point.lat);
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t id = ids[i];
+        distances[i] = point.lat == points.latitudes[id] && point.lng == points.longitudes[id] ? 0
+            : ComputeDistance(point.lng, point_sin, point_cos,
+                              points.longitudes[id], points.latitude_sines[id], points.latitude_cosines[id]);
+    }
 }
 
-}  // namespace geo
\ No newline at end of file
+}  // namespace geo
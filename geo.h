@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 namespace geo {
 
 struct Coordinates {
@@ -13,6 +16,29 @@ struct Coordinates {
     }
 };
 
+// Meters, the radius ComputeDistance works with
+inline constexpr double EARTH_RADIUS = 6371000;
+
 double ComputeDistance(Coordinates from, Coordinates to);
 
+// Points stored by columns, the index of a point is its index in each of them. ComputeDistance takes
+// the sine and cosine of both latitudes, so they are stored too and computed once per point
+struct PointColumns {
+    const double* latitudes = nullptr;
+    const double* longitudes = nullptr;
+    const double* latitude_sines = nullptr;
+    const double* latitude_cosines = nullptr;
+};
+
+// Sine and cosine of the latitude as PointColumns keeps them
+double ComputeLatitudeSine(double latitude);
+double ComputeLatitudeCosine(double latitude);
+
+// Same as ComputeDistance of the two points, to the last bit
+double ComputeDistance(const PointColumns& points, uint32_t from, uint32_t to);
+// distances[i] is the distance between points from[i] and to[i], i < count
+void ComputeDistances(const PointColumns& points, const uint32_t* from, const uint32_t* to, size_t count, double* distances);
+// distances[i] is the distance from the point to point ids[i], i < count
+void ComputeDistances(Coordinates point, const PointColumns& points, const uint32_t* ids, size_t count, double* distances);
+
 }  // namespace geo
\ No newline at end of file
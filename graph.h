@@ -2,7 +2,11 @@
 
 #include "ranges.h"
 
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
 namespace graph {
@@ -17,26 +21,69 @@ struct Edge {
     Weight weight;
 };
 
+// The graph is filled edge by edge and then frozen: incidence lists are packed into
+// compressed sparse rows, where outgoing edges of vertex v occupy positions
+// [offsets[v], offsets[v + 1]) of contiguous target, weight and edge id arrays.
+// Incoming edges are packed the same way for backward searches.
+// Routing engines traverse only the frozen form.
 template <typename Weight>
 class DirectedWeightedGraph {
 private:
-    using IncidenceList = std::vector<EdgeId>;
-    using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
+    using IncidenceList = std::vector<uint32_t>;
+    using IncidentEdgesRange = ranges::Range<const uint32_t*>;
 
 public:
+    // Outgoing edges of one vertex of a frozen graph
+    struct OutgoingEdges {
+        const uint32_t* targets;
+        const Weight* weights;
+        const uint32_t* edge_ids;
+        size_t count;
+    };
+    // Incoming edges of one vertex of a frozen graph
+    struct IncomingEdges {
+        const uint32_t* sources;
+        const Weight* weights;
+        const uint32_t* edge_ids;
+        size_t count;
+    };
+
+    static constexpr size_t MAX_EDGE_COUNT = std::numeric_limits<uint32_t>::max();
+
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
-    explicit DirectedWeightedGraph(std::vector<Edge<Weight>> edges, std::vector<IncidenceList> incidence_lists);
+    // Restores a frozen graph from its edges and compressed rows of outgoing edge ids
+    DirectedWeightedGraph(std::vector<Edge<Weight>> edges, std::vector<uint32_t> offsets, std::vector<uint32_t> edge_ids);
     EdgeId AddEdge(const Edge<Weight>& edge);
+    // Packs incidence lists into compressed sparse rows, no edges can be added afterwards
+    void Freeze();
 
+    bool IsFrozen() const;
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
     const Edge<Weight>& GetEdge(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+    // Frozen graphs only
+    OutgoingEdges GetOutgoingEdges(VertexId vertex) const;
+    IncomingEdges GetIncomingEdges(VertexId vertex) const;
+    const std::vector<uint32_t>& GetOffsets() const;
+    const std::vector<uint32_t>& GetOutgoingEdgeIds() const;
 
 private:
+    void FillRows();
+
     std::vector<Edge<Weight>> edges_;
     std::vector<IncidenceList> incidence_lists_;
+
+    bool is_frozen_ = false;
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> targets_;
+    std::vector<Weight> weights_;
+    std::vector<uint32_t> edge_ids_;
+    std::vector<uint32_t> incoming_offsets_;
+    std::vector<uint32_t> incoming_sources_;
+    std::vector<Weight> incoming_weights_;
+    std::vector<uint32_t> incoming_edge_ids_;
 };
 
 template <typename Weight>
@@ -45,21 +92,102 @@ DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
 }
 
 template <typename Weight>
-DirectedWeightedGraph<Weight>::DirectedWeightedGraph(std::vector<Edge<Weight>> edges, std::vector<IncidenceList> incidence_lists)
-    : edges_(edges)
-    , incidence_lists_(incidence_lists) {}
+DirectedWeightedGraph<Weight>::DirectedWeightedGraph(std::vector<Edge<Weight>> edges, std::vector<uint32_t> offsets,
+                                                     std::vector<uint32_t> edge_ids)
+    : edges_(std::move(edges))
+    , is_frozen_(true)
+    , offsets_(std::move(offsets))
+    , edge_ids_(std::move(edge_ids))
+{
+    if (offsets_.empty() || offsets_.front() != 0 || offsets_.back() != edge_ids_.size()
+        || edge_ids_.size() != edges_.size()) {
+        throw std::invalid_argument("Compressed rows do not match the edges");
+    }
+    for (size_t vertex = 0; vertex + 1 < offsets_.size(); ++vertex) {
+        if (offsets_[vertex] > offsets_[vertex + 1]) {
+            throw std::invalid_argument("Compressed rows do not match the edges");
+        }
+        for (uint32_t i = offsets_[vertex]; i < offsets_[vertex + 1]; ++i) {
+            if (edge_ids_[i] >= edges_.size() || edges_[edge_ids_[i]].from != vertex) {
+                throw std::invalid_argument("Compressed rows do not match the edges");
+            }
+        }
+    }
+    FillRows();
+}
 
 template <typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
+    if (is_frozen_) {
+        throw std::logic_error("Edges can not be added to a frozen graph");
+    }
+    if (edges_.size() >= MAX_EDGE_COUNT) {
+        throw std::out_of_range("Edge id does not fit into 32 bits");
+    }
+    incidence_lists_.at(edge.from).push_back(static_cast<uint32_t>(edges_.size()));
     edges_.push_back(edge);
-    const EdgeId id = edges_.size() - 1;
-    incidence_lists_.at(edge.from).push_back(id);
-    return id;
+    return edges_.size() - 1;
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::Freeze() {
+    if (is_frozen_) {
+        return;
+    }
+    offsets_.assign(incidence_lists_.size() + 1, 0);
+    edge_ids_.clear();
+    edge_ids_.reserve(edges_.size());
+    for (size_t vertex = 0; vertex < incidence_lists_.size(); ++vertex) {
+        edge_ids_.insert(edge_ids_.end(), incidence_lists_[vertex].begin(), incidence_lists_[vertex].end());
+        offsets_[vertex + 1] = static_cast<uint32_t>(edge_ids_.size());
+    }
+    incidence_lists_.clear();
+    incidence_lists_.shrink_to_fit();
+    is_frozen_ = true;
+    FillRows();
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::FillRows() {
+    targets_.resize(edge_ids_.size());
+    weights_.resize(edge_ids_.size());
+    for (size_t i = 0; i < edge_ids_.size(); ++i) {
+        const Edge<Weight>& edge = edges_[edge_ids_[i]];
+        if (edge.to + 1 >= offsets_.size()) {
+            throw std::out_of_range("Edge leads out of graph");
+        }
+        targets_[i] = static_cast<uint32_t>(edge.to);
+        weights_[i] = edge.weight;
+    }
+
+    incoming_offsets_.assign(offsets_.size(), 0);
+    for (const Edge<Weight>& edge : edges_) {
+        ++incoming_offsets_[edge.to + 1];
+    }
+    for (size_t vertex = 0; vertex + 1 < offsets_.size(); ++vertex) {
+        incoming_offsets_[vertex + 1] += incoming_offsets_[vertex];
+    }
+    incoming_sources_.resize(edges_.size());
+    incoming_weights_.resize(edges_.size());
+    incoming_edge_ids_.resize(edges_.size());
+    std::vector<uint32_t> positions(incoming_offsets_.begin(), incoming_offsets_.end() - 1);
+    for (size_t edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+        const Edge<Weight>& edge = edges_[edge_id];
+        const uint32_t position = positions[edge.to]++;
+        incoming_sources_[position] = static_cast<uint32_t>(edge.from);
+        incoming_weights_[position] = edge.weight;
+        incoming_edge_ids_[position] = static_cast<uint32_t>(edge_id);
+    }
+}
+
+template <typename Weight>
+bool DirectedWeightedGraph<Weight>::IsFrozen() const {
+    return is_frozen_;
 }
 
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-    return incidence_lists_.size();
+    return is_frozen_ ? offsets_.size() - 1 : incidence_lists_.size();
 }
 
 template <typename Weight>
@@ -75,6 +203,38 @@ const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const
 template <typename Weight>
 typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-    return ranges::AsRange(incidence_lists_.at(vertex));
+    if (is_frozen_) {
+        if (vertex + 1 >= offsets_.size()) {
+            throw std::out_of_range("Vertex is out of graph");
+        }
+        return {edge_ids_.data() + offsets_[vertex], edge_ids_.data() + offsets_[vertex + 1]};
+    }
+    const IncidenceList& incidence_list = incidence_lists_.at(vertex);
+    return {incidence_list.data(), incidence_list.data() + incidence_list.size()};
+}
+
+template <typename Weight>
+typename DirectedWeightedGraph<Weight>::OutgoingEdges
+DirectedWeightedGraph<Weight>::GetOutgoingEdges(VertexId vertex) const {
+    const uint32_t begin = offsets_[vertex];
+    return {targets_.data() + begin, weights_.data() + begin, edge_ids_.data() + begin, offsets_[vertex + 1] - begin};
+}
+
+template <typename Weight>
+typename DirectedWeightedGraph<Weight>::IncomingEdges
+DirectedWeightedGraph<Weight>::GetIncomingEdges(VertexId vertex) const {
+    const uint32_t begin = incoming_offsets_[vertex];
+    return {incoming_sources_.data() + begin, incoming_weights_.data() + begin, incoming_edge_ids_.data() + begin,
+            incoming_offsets_[vertex + 1] - begin};
+}
+
+template <typename Weight>
+const std::vector<uint32_t>& DirectedWeightedGraph<Weight>::GetOffsets() const {
+    return offsets_;
+}
+
+template <typename Weight>
+const std::vector<uint32_t>& DirectedWeightedGraph<Weight>::GetOutgoingEdgeIds() const {
+    return edge_ids_;
 }
-}  // namespace graph
\ No newline at end of file
+}  // namespace graph
@@ -10,7 +10,12 @@ namespace json {
 			const auto dict = request.AsDict();
 			if (dict.at("type"s) == "Stop"s) {
 				std::string name_from = dict.at("name"s).AsString();
-				transport_catalogue.AddStop(name_from, dict.at("latitude"s).AsDouble(), dict.at("longitude"s).AsDouble());
+				if (const auto stop_id = transport_catalogue.FindStop(name_from)) {
+					transport_catalogue.SetStopCoordinates(*stop_id, dict.at("latitude"s).AsDouble(), dict.at("longitude"s).AsDouble());
+				}
+				else {
+					transport_catalogue.AddStop(name_from, dict.at("latitude"s).AsDouble(), dict.at("longitude"s).AsDouble());
+				}
 				for (const auto& item : dict.at("road_distances"s).AsDict()) {
 					Way way;
 					way.from_stop = name_from;
@@ -24,6 +29,7 @@ namespace json {
 		for (const auto& way : stop_to_stop_distance) {
 			transport_catalogue.AddWay(way.from_stop, way.to_stop, way.distance_);
 		}
+		transport_catalogue.BuildStopGrid();
 	}
 
 	void JSONReader::ProcessBuses(const json::Array& base_requests, TransportCatalogue& transport_catalogue) {
@@ -54,6 +60,7 @@ namespace json {
 				transport_catalogue.AddBus(dict.at("name"s).AsString(), std::move(stops), is_roundtrip, std::move(second_final_stop));
 			}
 		}
+		transport_catalogue.BuildStopBuses();
 	}
 
 	Input JSONReader::LoadInputMakeBase(std::istream& input, TransportCatalogue& transport_catalogue) {
@@ -82,10 +89,46 @@ namespace json {
 
 		Input result;
 		result.stat_requests = std::move(stat_requests);
+		if (doc.GetRoot().AsDict().count("routing_settings"s)) {
+			result.routing_settings = doc.GetRoot().AsDict().at("routing_settings"s).AsDict();
+		}
 		result.serialization_settings = std::move(serialization_settings);
 		return result;
     }
 
+    Input JSONReader::LoadInputUpdateBase(std::istream& input)
+    {
+        json::Document doc = json::Load(input);
+		const json::Dict& root = doc.GetRoot().AsDict();
+
+		Input result;
+		if (root.count("base_requests"s)) {
+			result.base_requests = root.at("base_requests"s).AsArray();
+		}
+		if (root.count("removed_buses"s)) {
+			result.removed_buses = root.at("removed_buses"s).AsArray();
+		}
+		result.serialization_settings = root.at("serialization_settings"s).AsDict();
+		return result;
+    }
+
+	void JSONReader::ProcessUpdate(const Input& update, TransportCatalogue& transport_catalogue)
+	{
+		for (const auto& bus_name : update.removed_buses) {
+			transport_catalogue.RemoveBus(bus_name.AsString());
+		}
+		for (const auto& request : update.base_requests) {
+			const auto& dict = request.AsDict();
+			if (dict.at("type"s) == "Bus"s) {
+				transport_catalogue.RemoveBus(dict.at("name"s).AsString());
+			}
+		}
+		ProcessStops(update.base_requests, transport_catalogue);
+		ProcessBuses(update.base_requests, transport_catalogue);
+		// Kept buses may pass stops the update moved or whose distances it changed
+		transport_catalogue.UpdateBusStats();
+	}
+
     BusInfo JSONReader::ProcessBusInfo(const std::string_view& requests_bus_info, const handler::RequestHandler& request_handler)
 	{
 		if (requests_bus_info.empty()) {
@@ -104,6 +147,15 @@ namespace json {
 		return stop_info;
 	}
 
+	transport_router::RouteEndpoint JSONReader::ParseRouteEndpoint(const json::Node& endpoint)
+	{
+		if (endpoint.IsString()) {
+			return endpoint.AsString();
+		}
+		const auto& point = endpoint.AsDict();
+		return geo::Coordinates{ point.at("lat"s).AsDouble(), point.at("lng"s).AsDouble() };
+	}
+
 	void JSONReader::PrintBusInfo(int id, const BusInfo& bus_info, std::ostream& out)
 	{
 		json::Builder answer;
@@ -122,7 +174,7 @@ namespace json {
 		json::Print(json::Document{ answer.Build() }, out);
 	}
 
-	void JSONReader::PrintStopInfo(int id, const StopInfo& stop_info, std::ostream& out)
+	void JSONReader::PrintStopInfo(int id, const StopInfo& stop_info, const handler::RequestHandler& request_handler, std::ostream& out)
 	{
 		json::Builder answer;
 		answer.StartDict().Key("request_id"s).Value(id);
@@ -132,8 +184,8 @@ namespace json {
 		}
 		else {
 			answer.Key("buses"s).StartArray();
-			for (const auto& bus : stop_info.buses) {
-				answer.Value(static_cast<std::string>(bus));
+			for (const uint32_t bus_id : stop_info.buses) {
+				answer.Value(std::string(request_handler.GetBusName(bus_id)));
 			}
 			answer.EndArray();
 		}
@@ -154,56 +206,216 @@ namespace json {
 		json::Print(json::Document{ answer.Build() }, out);
 	}
 
-	void JSONReader::PrintRouteInfo(const json::Dict& request, const handler::RequestHandler& request_handler, std::ostream& out)
+	void JSONReader::AddRouteItems(json::Builder& answer, const transport_router::RouteInfo& route)
+	{
+		answer.Key("items"s).StartArray();
+
+		for (const auto& item : route.items) {
+			answer.StartDict();
+			switch (item.type)
+			{
+			case transport_router::EdgeType::BUS:
+				answer.Key("type"s).Value("Bus"s)
+					.Key("bus"s).Value(std::string(item.name))
+					.Key("span_count"s).Value(item.span_count)						
+					.Key("time").Value(item.time);
+				break;
+			case transport_router::EdgeType::WAIT:
+				answer.Key("type"s).Value("Wait"s)
+					.Key("stop_name"s).Value(std::string(item.name))
+					.Key("time"s).Value(item.time);
+				break;
+			case transport_router::EdgeType::WALK:
+				answer.Key("type"s).Value("Walk"s);
+				if (!item.name.empty()) {
+					answer.Key("stop_name"s).Value(std::string(item.name));
+				}
+				answer.Key("time"s).Value(item.time);
+				break;
+			}
+			answer.EndDict();
+		}
+
+		answer.EndArray();
+
+		answer.Key("total_time").Value(route.total_time);
+	}
+
+	void JSONReader::PrintRouteInfo(const json::Dict& request, const std::optional<transport_router::RouteInfo>& route, std::ostream& out)
 	{
 		json::Builder answer;
 		answer.StartDict()
 			.Key("request_id"s).Value(request.at("id"s));
 
-		const auto route = request_handler.BuildRoute(request.at("from"s).AsString(), request.at("to"s).AsString());
-
 		if (!route.has_value()) {
 			answer.Key("error_message"s).Value("not found"s);
 		}
 		else {
+			AddRouteItems(answer, route.value());
+		}			
+			answer.EndDict();
+		json::Print(json::Document{ answer.Build() }, out);
+	}
 
-			answer.Key("items"s).StartArray();
+	void JSONReader::PrintAlternativeRoutes(const json::Dict& request, const handler::RequestHandler& request_handler, std::ostream& out)
+	{
+		const int max_count = request.count("max_count"s) ? request.at("max_count"s).AsInt() : static_cast<int>(DEFAULT_ALTERNATIVE_ROUTE_COUNT);
+		if (max_count < 0) {
+			throw std::invalid_argument("max_count of a Routes request should be non-negative"s);
+		}
+		std::optional<std::chrono::milliseconds> latency_budget;
+		if (request.count("latency_budget_ms"s)) {
+			const int latency_budget_ms = request.at("latency_budget_ms"s).AsInt();
+			if (latency_budget_ms < 0) {
+				throw std::invalid_argument("latency_budget_ms of a Routes request should be non-negative"s);
+			}
+			latency_budget = std::chrono::milliseconds(latency_budget_ms);
+		}
+		const auto routes = request_handler.BuildAlternativeRoutes(request.at("from"s).AsString(), request.at("to"s).AsString()
+			, static_cast<size_t>(max_count), latency_budget);
 
-			for (const auto& edge_id : route.value().edges) {
+		json::Builder answer;
+		answer.StartDict()
+			.Key("request_id"s).Value(request.at("id"s));
+		if (routes.empty()) {
+			answer.Key("error_message"s).Value("not found"s);
+		}
+		else {
+			answer.Key("routes"s).StartArray();
+			for (const auto& route : routes) {
 				answer.StartDict();
-				const auto [edge, edge_info] = request_handler.GetFullEdgeInfo(edge_id);
-				switch (edge_info.type)
-				{
-				case transport_router::EdgeType::BUS:
-					answer.Key("type"s).Value("Bus"s)
-						.Key("bus"s).Value(std::string(edge_info.bus))
-						.Key("span_count"s).Value(edge_info.span_count)						
-						.Key("time").Value(edge.weight);
-					break;
-				case transport_router::EdgeType::WAIT:
-					answer.Key("type"s).Value("Wait"s)
-						.Key("stop_name"s).Value(std::string(edge_info.stop_name))
-						.Key("time"s).Value(edge.weight);
-					break;
-				}
+				AddRouteItems(answer, route);
 				answer.EndDict();
 			}
+			answer.EndArray();
+		}
+		answer.EndDict();
+		json::Print(json::Document{ answer.Build() }, out);
+	}
 
+	void JSONReader::PrintRouteMatrix(const json::Dict& request, const handler::RequestHandler& request_handler, std::ostream& out)
+	{
+		std::vector<std::string> sources;
+		for (const auto& stop : request.at("from"s).AsArray()) {
+			sources.push_back(stop.AsString());
+		}
+		std::vector<std::string> targets;
+		for (const auto& stop : request.at("to"s).AsArray()) {
+			targets.push_back(stop.AsString());
+		}
+
+		json::Builder answer;
+		answer.StartDict()
+			.Key("request_id"s).Value(request.at("id"s))
+			.Key("total_times"s).StartArray();
+		for (const auto& row : request_handler.BuildRoutes(sources, targets)) {
+			answer.StartArray();
+			for (const auto& total_time : row) {
+				if (total_time.has_value()) {
+					answer.Value(total_time.value());
+				}
+				else {
+					answer.Value(nullptr);
+				}
+			}
 			answer.EndArray();
+		}
+		answer.EndArray()
+			.EndDict();
+		json::Print(json::Document{ answer.Build() }, out);
+	}
 
-			answer.Key("total_time").Value(route.value().weight);
+	void JSONReader::PrintReachableStops(const json::Dict& request, const handler::RequestHandler& request_handler, std::ostream& out)
+	{
+		json::Builder answer;
+		answer.StartDict()
+			.Key("request_id"s).Value(request.at("id"s))
+			.Key("stops"s).StartArray();
+		for (const auto& stop : request_handler.BuildReachableStops(request.at("from"s).AsString(), request.at("max_time"s).AsDouble())) {
+			answer.StartDict()
+				.Key("stop_name"s).Value(std::string(stop.name))
+				.Key("time"s).Value(stop.time)
+				.EndDict();
+		}
+		answer.EndArray()
+			.EndDict();
+		json::Print(json::Document{ answer.Build() }, out);
+	}
 
-		}			
-			answer.EndDict();
+	void JSONReader::PrintNearestStops(const json::Dict& request, const handler::RequestHandler& request_handler, std::ostream& out)
+	{
+		const int max_count = request.count("k"s) ? request.at("k"s).AsInt() : static_cast<int>(DEFAULT_NEAREST_STOP_COUNT);
+		if (max_count < 0) {
+			throw std::invalid_argument("k of a NearestStops request should be non-negative"s);
+		}
+		const double max_distance = request.count("radius"s) ? request.at("radius"s).AsDouble() : std::numeric_limits<double>::infinity();
+		if (max_distance < 0.) {
+			throw std::invalid_argument("radius of a NearestStops request should be non-negative"s);
+		}
+		const geo::Coordinates point{ request.at("lat"s).AsDouble(), request.at("lng"s).AsDouble() };
+
+		json::Builder answer;
+		answer.StartDict()
+			.Key("request_id"s).Value(request.at("id"s))
+			.Key("stops"s).StartArray();
+		for (const auto& stop : request_handler.FindNearestStops(point, static_cast<size_t>(max_count), max_distance)) {
+			answer.StartDict()
+				.Key("stop_name"s).Value(std::string(stop.stop_name))
+				.Key("distance"s).Value(stop.distance)
+				.EndDict();
+		}
+		answer.EndArray()
+			.EndDict();
 		json::Print(json::Document{ answer.Build() }, out);
 	}
 
+	std::vector<std::optional<transport_router::RouteInfo>> JSONReader::ProcessRoutes(const json::Array& stat_requests, const handler::RequestHandler& request_handler)
+	{
+		std::vector<std::optional<transport_router::RouteInfo>> routes(stat_requests.size());
+		// Origins in the order of their first request, to keep the work independent of hashing
+		std::vector<std::string> origins;
+		std::unordered_map<std::string, std::vector<size_t>> requests_by_origin;
+		for (size_t i = 0; i < stat_requests.size(); ++i) {
+			const auto& dict = stat_requests[i].AsDict();
+			if (dict.at("type"s) != "Route"s) {
+				continue;
+			}
+			if (!dict.at("from"s).IsString() || !dict.at("to"s).IsString()) {
+				routes[i] = request_handler.BuildRoute(ParseRouteEndpoint(dict.at("from"s)), ParseRouteEndpoint(dict.at("to"s)));
+				continue;
+			}
+			const std::string& from = dict.at("from"s).AsString();
+			const auto [it, is_inserted] = requests_by_origin.try_emplace(from);
+			if (is_inserted) {
+				origins.push_back(from);
+			}
+			it->second.push_back(i);
+		}
+
+		for (const std::string& origin : origins) {
+			const std::vector<size_t>& indexes = requests_by_origin.at(origin);
+			std::vector<std::string> targets;
+			targets.reserve(indexes.size());
+			for (const size_t i : indexes) {
+				targets.push_back(stat_requests[i].AsDict().at("to"s).AsString());
+			}
+			auto origin_routes = request_handler.BuildRoutesFrom(origin, targets);
+			for (size_t k = 0; k < indexes.size(); ++k) {
+				routes[indexes[k]] = std::move(origin_routes[k]);
+			}
+		}
+		return routes;
+	}
+
 	void JSONReader::ProcessStatRequests(const json::Array& stat_requests, const handler::RequestHandler& request_handler, std::ostream& out)
 	{
+		const auto routes = ProcessRoutes(stat_requests, request_handler);
+		size_t index = 0;
 		bool is_first = true;
 		out << '[';
 		for (const auto& request : stat_requests) {
-			const auto dict = request.AsDict();
+			const auto& dict = request.AsDict();
+			const size_t request_index = index++;
 			if (dict.at("type"s) == "Bus"s) {
 				if (is_first) {
 					PrintBusInfo(dict.at("id"s).AsInt(), ProcessBusInfo(dict.at("name"s).AsString(), request_handler), out);
@@ -215,12 +427,12 @@ namespace json {
 			}
 			else if (dict.at("type"s) == "Stop"s) {
 				if (is_first) {
-					PrintStopInfo(dict.at("id"s).AsInt(), ProcessStopInfo(dict.at("name"s).AsString(), request_handler), out);
+					PrintStopInfo(dict.at("id"s).AsInt(), ProcessStopInfo(dict.at("name"s).AsString(), request_handler), request_handler, out);
 					is_first = false;
 					continue;
 				}
 				out << ',';
-				PrintStopInfo(dict.at("id"s).AsInt(), ProcessStopInfo(dict.at("name"s).AsString(), request_handler), out);
+				PrintStopInfo(dict.at("id"s).AsInt(), ProcessStopInfo(dict.at("name"s).AsString(), request_handler), request_handler, out);
 			}
 			else if (dict.at("type"s) == "Map"s) {
 				if (is_first) {
@@ -233,12 +445,48 @@ namespace json {
 			}
 			else if (dict.at("type"s) == "Route"s) {
 				if (is_first) {
-					PrintRouteInfo(dict, request_handler, out);
+					PrintRouteInfo(dict, routes[request_index], out);
+					is_first = false;
+					continue;
+				}
+				out << ',';
+				PrintRouteInfo(dict, routes[request_index], out);
+			}
+			else if (dict.at("type"s) == "Routes"s) {
+				if (is_first) {
+					PrintAlternativeRoutes(dict, request_handler, out);
+					is_first = false;
+					continue;
+				}
+				out << ',';
+				PrintAlternativeRoutes(dict, request_handler, out);
+			}
+			else if (dict.at("type"s) == "RouteMatrix"s) {
+				if (is_first) {
+					PrintRouteMatrix(dict, request_handler, out);
+					is_first = false;
+					continue;
+				}
+				out << ',';
+				PrintRouteMatrix(dict, request_handler, out);
+			}
+			else if (dict.at("type"s) == "Reachable"s) {
+				if (is_first) {
+					PrintReachableStops(dict, request_handler, out);
+					is_first = false;
+					continue;
+				}
+				out << ',';
+				PrintReachableStops(dict, request_handler, out);
+			}
+			else if (dict.at("type"s) == "NearestStops"s) {
+				if (is_first) {
+					PrintNearestStops(dict, request_handler, out);
 					is_first = false;
 					continue;
 				}
 				out << ',';
-				PrintRouteInfo(dict, request_handler, out);
+				PrintNearestStops(dict, request_handler, out);
 			}
 		}
 		out << ']';
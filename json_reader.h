@@ -6,10 +6,16 @@
 #include <string_view>
 #include <algorithm>
 #include <sstream>
+#include <chrono>
+#include <optional>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
 
 #include "request_handler.h"
 #include "transport_catalogue.h"
 #include "json.h"
+#include "json_builder.h"
 
 namespace json {
 	using namespace std::string_literals;
@@ -30,22 +36,44 @@ namespace json {
 		json::Dict render_settings;
 		json::Dict routing_settings;
 		json::Dict serialization_settings;
+		// Names of the buses an update removes from the base
+		json::Array removed_buses;
 	};
 
 	class JSONReader
 	{
 	public:
+		static constexpr size_t DEFAULT_ALTERNATIVE_ROUTE_COUNT = 3;
+		static constexpr size_t DEFAULT_NEAREST_STOP_COUNT = 1;
+
 		void ProcessStops(const json::Array& base_requests, TransportCatalogue& transport_catalogue);
 		void ProcessBuses(const json::Array& base_requests, TransportCatalogue& transport_catalogue);
 		Input LoadInputMakeBase(std::istream& input, TransportCatalogue& transport_catalogue);
 		Input LoadInputProessRequests(std::istream& input, TransportCatalogue& transport_catalogue);
+		// Reads an update of an existing base, which is applied by ProcessUpdate once the base is loaded
+		Input LoadInputUpdateBase(std::istream& input);
+		// Removes the listed buses, replaces buses of the same names and adds the new stops and buses.
+		// A Stop request for a known stop updates its coordinates and road distances
+		void ProcessUpdate(const Input& update, TransportCatalogue& transport_catalogue);
 
 		void ProcessStatRequests(const json::Array& stat_requests, const handler::RequestHandler& request_handler, std::ostream& out);
 		BusInfo ProcessBusInfo(const std::string_view& requests_bus_info, const handler::RequestHandler& request_handler);
 		StopInfo ProcessStopInfo(const std::string_view& requests_stop_info, const handler::RequestHandler& request_handler);
+		// Answers every Route request of the batch, indexed as the requests are. Requests between stops are
+		// grouped by their "from" stop, and all destinations of one origin are found by a single search.
+		// A request from or to coordinates is answered on its own
+		std::vector<std::optional<transport_router::RouteInfo>> ProcessRoutes(const json::Array& stat_requests, const handler::RequestHandler& request_handler);
+		// A stop name or a dict of "lat" and "lng"
+		transport_router::RouteEndpoint ParseRouteEndpoint(const json::Node& endpoint);
 		void PrintBusInfo(int id, const BusInfo& bus_info, std::ostream& out);
-		void PrintStopInfo(int id, const StopInfo& stop_info, std::ostream& out);
+		void PrintStopInfo(int id, const StopInfo& stop_info, const handler::RequestHandler& request_handler, std::ostream& out);
 		void PrintMapInfo(int id, const handler::RequestHandler& request_handler, std::ostream& out);
-		void PrintRouteInfo(const json::Dict& request, const handler::RequestHandler& request_handler, std::ostream& out);
+		// Writes "items" and "total_time" of a route into the current dict
+		void AddRouteItems(json::Builder& answer, const transport_router::RouteInfo& route);
+		void PrintRouteInfo(const json::Dict& request, const std::optional<transport_router::RouteInfo>& route, std::ostream& out);
+		void PrintAlternativeRoutes(const json::Dict& request, const handler::RequestHandler& request_handler, std::ostream& out);
+		void PrintRouteMatrix(const json::Dict& request, const handler::RequestHandler& request_handler, std::ostream& out);
+		void PrintReachableStops(const json::Dict& request, const handler::RequestHandler& request_handler, std::ostream& out);
+		void PrintNearestStops(const json::Dict& request, const handler::RequestHandler& request_handler, std::ostream& out);
 	};	
 }
\ No newline at end of file
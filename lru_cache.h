@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+namespace lru_cache {
+
+// Bounded least-recently-used cache split into independently locked shards, so
+// concurrent lookups of different keys rarely wait for each other. Every shard
+// evicts on its own, the total size never exceeds the capacity.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class ShardedLruCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+    static constexpr size_t DEFAULT_SHARD_COUNT = 16;
+
+    explicit ShardedLruCache(size_t capacity, size_t shard_count = DEFAULT_SHARD_COUNT);
+
+    std::optional<Value> Get(const Key& key);
+    void Put(const Key& key, Value value);
+    // Returns the cached value or computes, caches and returns a new one.
+    // The computation runs outside the lock, concurrent misses of one key may compute it twice
+    template <typename Compute>
+    Value GetOrCompute(const Key& key, Compute compute);
+
+    size_t GetCapacity() const;
+    Stats GetStats() const;
+
+private:
+    struct Shard {
+        using Entries = std::list<std::pair<Key, Value>>;
+
+        std::mutex mutex;
+        size_t capacity = 0;
+        // Most recently used first
+        Entries entries;
+        std::unordered_map<Key, typename Entries::iterator, Hash> index;
+    };
+
+    Shard& GetShard(const Key& key) {
+        // Hash values of consecutive keys are often consecutive too, so they are mixed
+        // before picking a shard
+        const uint64_t mixed = static_cast<uint64_t>(Hash{}(key)) * 0x9E3779B97F4A7C15ull;
+        return shards_[(mixed >> 32) % shard_count_];
+    }
+
+    size_t capacity_;
+    size_t shard_count_;
+    std::unique_ptr<Shard[]> shards_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
+
+template <typename Key, typename Value, typename Hash>
+ShardedLruCache<Key, Value, Hash>::ShardedLruCache(size_t capacity, size_t shard_count)
+    : capacity_(capacity)
+    , shard_count_(std::max<size_t>(1, std::min(shard_count, capacity)))
+    , shards_(std::make_unique<Shard[]>(shard_count_))
+{
+    for (size_t i = 0; i < shard_count_; ++i) {
+        shards_[i].capacity = capacity / shard_count_ + (i < capacity % shard_count_ ? 1 : 0);
+    }
+}
+
+template <typename Key, typename Value, typename Hash>
+std::optional<Value> ShardedLruCache<Key, Value, Hash>::Get(const Key& key) {
+    Shard& shard = GetShard(key);
+    std::lock_guard guard(shard.mutex);
+    const auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        ++misses_;
+        return std::nullopt;
+    }
+    ++hits_;
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    return it->second->second;
+}
+
+template <typename Key, typename Value, typename Hash>
+void ShardedLruCache<Key, Value, Hash>::Put(const Key& key, Value value) {
+    Shard& shard = GetShard(key);
+    if (shard.capacity == 0) {
+        return;
+    }
+    std::lock_guard guard(shard.mutex);
+    if (const auto it = shard.index.find(key); it != shard.index.end()) {
+        it->second->second = std::move(value);
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return;
+    }
+    if (shard.entries.size() == shard.capacity) {
+        shard.index.erase(shard.entries.back().first);
+        shard.entries.pop_back();
+    }
+    shard.entries.emplace_front(key, std::move(value));
+    shard.index.emplace(key, shard.entries.begin());
+}
+
+template <typename Key, typename Value, typename Hash>
+template <typename Compute>
+Value ShardedLruCache<Key, Value, Hash>::GetOrCompute(const Key& key, Compute compute) {
+    if (auto value = Get(key)) {
+        return std::move(*value);
+    }
+    Value value = compute();
+    Put(key, value);
+    return value;
+}
+
+template <typename Key, typename Value, typename Hash>
+size_t ShardedLruCache<Key, Value, Hash>::GetCapacity() const {
+    return capacity_;
+}
+
+template <typename Key, typename Value, typename Hash>
+typename ShardedLruCache<Key, Value, Hash>::Stats ShardedLruCache<Key, Value, Hash>::GetStats() const {
+    return {hits_.load(), misses_.load()};
+}
+
+}  // namespace lru_cache
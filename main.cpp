@@ -11,18 +11,51 @@
 using namespace std::literals;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base [--update]|process_requests]\n"sv;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
+    const bool is_update = argc == 3 && argv[2] == "--update"sv;
+    if (argc != 2 && !is_update) {
         PrintUsage();
         return 1;
     }
 
     const std::string_view mode(argv[1]);
 
-    if (mode == "make_base"sv) {
+    if (mode == "make_base"sv && is_update) {
+        // Applies a delta to an existing base and writes the base back in place
+        transport_catalogue::data_base::TransportCatalogue transport_catalogue;
+        json::JSONReader json_reader;
+        json::Input update = json_reader.LoadInputUpdateBase(std::cin);
+        const std::string file_name = update.serialization_settings.at("file"s).AsString();
+
+        std::ifstream file_in(file_name, std::ios::binary);
+        if (!file_in) {
+            std::cerr << "Cannot open base "sv << file_name << '\n';
+            return 1;
+        }
+        auto [render_settings, router, graph, router_data] = Serialization::Deserialize(transport_catalogue, file_in);
+        file_in.close();
+
+        // Rides of the base refer to buses by indexes, which the update shifts
+        std::vector<std::string> previous_bus_names;
+        for (const auto& bus : transport_catalogue.GetBuses()) {
+            previous_bus_names.push_back(bus.name);
+        }
+        json_reader.ProcessUpdate(update, transport_catalogue);
+        router.UpdateGraph(std::move(graph), std::move(router_data), previous_bus_names);
+
+        std::ofstream file_out(file_name, std::ios::binary);
+        if(file_out.is_open()) {
+            Serialization::Serialize(transport_catalogue, render_settings, router, file_out);
+        }
+
+    } else if (is_update) {
+        PrintUsage();
+        return 1;
+
+    } else if (mode == "make_base"sv) {
 
         transport_catalogue::data_base::TransportCatalogue transport_catalogue;
         json::JSONReader json_reader;
@@ -42,10 +75,14 @@ int main(int argc, char* argv[]) {
            
         std::ifstream in_file(input.serialization_settings.at("file"s).AsString(), std::ios::binary);
         if(in_file) {
-            auto [render_settings, router, graph] = Serialization::Deserialize(transport_catalogue, in_file);
+            auto [render_settings, router, graph, router_data] = Serialization::Deserialize(transport_catalogue, in_file);
 
             map_renderer::MapRenderer renderer(transport_catalogue, render_settings);
-            router.SetGraph(graph);
+            router.SetGraph(std::move(graph), std::move(router_data));
+            if (!input.routing_settings.empty()) {
+                // Settings of this run only, the base keeps its own
+                router.SetRoutingMetric(input.routing_settings);
+            }
             handler::RequestHandler request_handler(transport_catalogue, renderer, router);
 
             json_reader.ProcessStatRequests(input.stat_requests, request_handler, std::cout);
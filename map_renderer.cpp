@@ -171,7 +171,7 @@ namespace map_renderer {
             svg::Text underlauer_text;
             svg::Text route_name_text;
             
-            const auto first_stop_point = proj({ bus->stops[0]->latitude, bus->stops[0]->longitude });
+            const auto first_stop_point = proj(db_.GetStopCoordinates(bus->stops[0]));
             doc_.Add(underlauer_text.SetFillColor(this->GetUnderlayerColor()).
                 SetStrokeColor(this->GetUnderlayerColor()).
                 SetStrokeWidth(this->GetUnderlayerWidth()).
@@ -193,7 +193,7 @@ namespace map_renderer {
                 SetData(static_cast<std::string>(bus_name)));
 
             if (bus->type == transport_catalogue::data_base::RouteType::TWO_DIRECTIONAL && bus->stops[0] != bus->second_final_stop) {
-                const auto second_stop_point = proj({ bus->second_final_stop.value()->latitude, bus->second_final_stop.value()->longitude});
+                const auto second_stop_point = proj(db_.GetStopCoordinates(bus->second_final_stop.value()));
                 doc_.Add(underlauer_text.SetFillColor(this->GetUnderlayerColor()).
                     SetStrokeColor(this->GetUnderlayerColor()).
                     SetStrokeWidth(this->GetUnderlayerWidth()).
@@ -218,11 +218,11 @@ namespace map_renderer {
         }
     }
 
-    void MapRenderer::RenderStopCircles(const std::set<transport_catalogue::data_base::Stop*, CmpStop>& all_stops, const SphereProjector& proj)
+    void MapRenderer::RenderStopCircles(const std::vector<uint32_t>& all_stops, const SphereProjector& proj)
     {
-        for (const auto stop : all_stops) {
+        for (const uint32_t stop_id : all_stops) {
             svg::Circle stop_circle;
-            svg::Point center = proj({ stop->latitude, stop->longitude });
+            svg::Point center = proj(db_.GetStopCoordinates(stop_id));
             doc_.Add(stop_circle.
                 SetCenter(center).
                 SetRadius(this->GetStopRadius()).
@@ -230,12 +230,13 @@ namespace map_renderer {
         }
     }
 
-    void MapRenderer::RenderStopNames(const std::set<transport_catalogue::data_base::Stop*, CmpStop>& all_stops, const SphereProjector& proj)
+    void MapRenderer::RenderStopNames(const std::vector<uint32_t>& all_stops, const SphereProjector& proj)
     {
-        for (const auto stop : all_stops) {
+        for (const uint32_t stop_id : all_stops) {
+            const std::string stop_name(db_.GetStopName(stop_id));
             svg::Text underlauer_text;
             svg::Text stop_name_text;
-            svg::Point position = proj({ stop->latitude, stop->longitude });
+            svg::Point position = proj(db_.GetStopCoordinates(stop_id));
             doc_.Add(underlauer_text.
                 SetFillColor(this->GetUnderlayerColor()).
                 SetStrokeColor(this->GetUnderlayerColor()).
@@ -246,7 +247,7 @@ namespace map_renderer {
                 SetOffset(this->GetStopLabelOffset()).
                 SetFontSize(this->GetStopLabelFontSize()).
                 SetFontFamily("Verdana"s).
-                SetData(stop->name));
+                SetData(stop_name));
 
             doc_.Add(stop_name_text.
                 SetFillColor("black"s).                
@@ -254,13 +255,13 @@ namespace map_renderer {
                 SetOffset(this->GetStopLabelOffset()).
                 SetFontSize(this->GetStopLabelFontSize()).
                 SetFontFamily("Verdana"s).
-                SetData(stop->name));
+                SetData(stop_name));
         }
     }
 
     void MapRenderer::RenderMap()
     {
-        auto buses = db_.GetBuses();
+        const auto& buses = db_.GetBuses();
         std::vector<std::string_view> buses_names;
         for (const auto& bus : buses) {
             buses_names.emplace_back(bus.name);
@@ -286,13 +287,15 @@ namespace map_renderer {
             this->GetHeight(),
             this->GetPadding());
 
-        std::set<transport_catalogue::data_base::Stop*, CmpStop> all_stops;
-        for (const auto bus_name : buses_names) {
-            const auto bus = db_.FindBus(bus_name);
-            for (const auto stop : bus->stops) {
-                all_stops.insert(stop);
-            }
+        std::vector<uint32_t> all_stops;
+        for (const auto& bus : buses) {
+            all_stops.insert(all_stops.end(), bus.stops.begin(), bus.stops.end());
         }
+        std::sort(all_stops.begin(), all_stops.end());
+        all_stops.erase(std::unique(all_stops.begin(), all_stops.end()), all_stops.end());
+        std::sort(all_stops.begin(), all_stops.end(), [this](uint32_t lhs, uint32_t rhs) {
+            return db_.GetStopName(lhs) < db_.GetStopName(rhs);
+        });
 
         RenderRoutes(routes_coordinates, proj);
         RenderRoutNames(buses_names, proj);
@@ -308,12 +311,12 @@ namespace map_renderer {
     std::vector<geo::Coordinates> MapRenderer::GetRouteCoordinates(std::string_view name_bus)
     {
         std::vector<geo::Coordinates> result;
-        auto bus = db_.FindBus(name_bus);
-        for (const auto& stop : bus->stops) {
-            geo::Coordinates coordinates;
-            coordinates.lat = stop->latitude;
-            coordinates.lng = stop->longitude;
-            result.push_back(coordinates);
+        const auto bus = db_.FindBus(name_bus);
+        const auto& latitudes = db_.GetStopLatitudes();
+        const auto& longitudes = db_.GetStopLongitudes();
+        result.reserve(bus->stops.size());
+        for (const uint32_t stop_id : bus->stops) {
+            result.push_back({ latitudes[stop_id], longitudes[stop_id] });
         }
         return result;
     }
@@ -100,12 +100,6 @@ namespace map_renderer {
         std::vector<svg::Color> color_palette{};
     };
     
-    struct CmpStop {
-        bool operator()(const transport_catalogue::data_base::Stop* lhs, const transport_catalogue::data_base::Stop* rhs) const {
-            return lhs->name < rhs->name;
-        }
-    };
-
     class MapRenderer
     {
     public:
@@ -129,8 +123,9 @@ namespace map_renderer {
 
         void RenderRoutes(const std::vector<std::vector<geo::Coordinates>>& routes_coordinates, const SphereProjector& proj);
         void RenderRoutNames(const std::vector<std::string_view>& buses_names, const SphereProjector& proj);
-        void RenderStopCircles(const std::set<transport_catalogue::data_base::Stop*, CmpStop>& all_stops, const SphereProjector& proj);
-        void RenderStopNames(const std::set<transport_catalogue::data_base::Stop*, CmpStop>& all_stops, const SphereProjector& proj);
+        // Stops are given by ids, in the order of their names
+        void RenderStopCircles(const std::vector<uint32_t>& all_stops, const SphereProjector& proj);
+        void RenderStopNames(const std::vector<uint32_t>& all_stops, const SphereProjector& proj);
         void RenderMap();
 
         const svg::Document& GetDocument() const;
@@ -0,0 +1,250 @@
+#include "raptor_router.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace transport_router {
+	namespace {
+		constexpr double INFINITE_TIME = std::numeric_limits<double>::infinity();
+		constexpr uint32_t NO_POSITION = std::numeric_limits<uint32_t>::max();
+	}
+
+	RaptorRouter::RaptorRouter(const TransportCatalogue& tc, int bus_wait_time, double bus_velocity)
+		: wait_time_(bus_wait_time)
+		, velocity_(bus_velocity * (1000.0 / 60.0))		// convertion from km/h to m/min
+		, stop_count_(tc.GetStopCount())
+	{
+		for (const auto& bus : tc.GetBuses()) {
+			switch (bus.type)
+			{
+			case transport_catalogue::data_base::RouteType::CIRCLE:
+				AddPattern(bus, 0, bus.stops.size());
+				break;
+			case transport_catalogue::data_base::RouteType::TWO_DIRECTIONAL:
+			{
+				const size_t mid = bus.stops.size() / 2;
+				AddPattern(bus, 0, mid + 1);
+				AddPattern(bus, mid, bus.stops.size());
+				break;
+			}
+			}
+		}
+
+		stop_pattern_offsets_.assign(stop_count_ + 1, 0);
+		for (const Pattern& pattern : patterns_) {
+			for (const uint32_t stop : pattern.stops) {
+				++stop_pattern_offsets_[stop + 1];
+			}
+		}
+		for (size_t stop = 0; stop < stop_count_; ++stop) {
+			stop_pattern_offsets_[stop + 1] += stop_pattern_offsets_[stop];
+		}
+		stop_patterns_.resize(stop_pattern_offsets_.back());
+		std::vector<uint32_t> positions(stop_pattern_offsets_.begin(), stop_pattern_offsets_.end() - 1);
+		for (uint32_t pattern = 0; pattern < patterns_.size(); ++pattern) {
+			const auto& pattern_stops = patterns_[pattern].stops;
+			for (uint32_t position = 0; position < pattern_stops.size(); ++position) {
+				stop_patterns_[positions[pattern_stops[position]]++] = { pattern, position };
+			}
+		}
+	}
+
+	void RaptorRouter::AddPattern(const Bus& bus, size_t begin, size_t end)
+	{
+		if (end < begin + 2) {
+			return;
+		}
+		Pattern pattern;
+		pattern.bus = &bus;
+		pattern.stops.assign(bus.stops.begin() + begin, bus.stops.begin() + end);
+		for (size_t position = begin; position < end; ++position) {
+			pattern.distances.push_back(bus.road_distances[position] - bus.road_distances[begin]);
+		}
+		patterns_.push_back(std::move(pattern));
+	}
+
+	std::optional<RaptorRouter::Journey> RaptorRouter::BuildRoute(size_t from_stop, size_t to_stop) const
+	{
+		if (from_stop >= stop_count_ || to_stop >= stop_count_) {
+			throw std::out_of_range("Stop is out of router");
+		}
+
+		std::vector<double> arrivals;
+		std::vector<Parent> parents;
+		Search({ { from_stop, 0 } }, { { to_stop, 0 } }, INFINITE_TIME, arrivals, parents);
+		return MakeJourney(to_stop, arrivals, parents);
+	}
+
+	std::vector<std::optional<RaptorRouter::Journey>> RaptorRouter::BuildRoutes(size_t from_stop, const std::vector<size_t>& to_stops) const
+	{
+		if (from_stop >= stop_count_) {
+			throw std::out_of_range("Stop is out of router");
+		}
+		for (const size_t to_stop : to_stops) {
+			if (to_stop >= stop_count_) {
+				throw std::out_of_range("Stop is out of router");
+			}
+		}
+
+		std::vector<double> arrivals;
+		std::vector<Parent> parents;
+		Search({ { from_stop, 0 } }, {}, INFINITE_TIME, arrivals, parents);
+		std::vector<std::optional<Journey>> journeys;
+		journeys.reserve(to_stops.size());
+		for (const size_t to_stop : to_stops) {
+			journeys.push_back(MakeJourney(to_stop, arrivals, parents));
+		}
+		return journeys;
+	}
+
+	std::optional<RaptorRouter::Journey> RaptorRouter::BuildRoute(const std::vector<StopTime>& from_stops, const std::vector<StopTime>& to_stops) const
+	{
+		for (const auto& stop_times : { &from_stops, &to_stops }) {
+			for (const StopTime& stop_time : *stop_times) {
+				if (stop_time.stop >= stop_count_) {
+					throw std::out_of_range("Stop is out of router");
+				}
+			}
+		}
+
+		std::vector<double> arrivals;
+		std::vector<Parent> parents;
+		Search(from_stops, to_stops, INFINITE_TIME, arrivals, parents);
+		std::optional<size_t> best_stop;
+		double best_time = INFINITE_TIME;
+		for (const StopTime& to_stop : to_stops) {
+			if (arrivals[to_stop.stop] + to_stop.time < best_time) {
+				best_stop = to_stop.stop;
+				best_time = arrivals[to_stop.stop] + to_stop.time;
+			}
+		}
+		if (!best_stop) {
+			return std::nullopt;
+		}
+		return MakeJourney(*best_stop, arrivals, parents);
+	}
+
+	std::optional<RaptorRouter::Journey> RaptorRouter::MakeJourney(size_t to_stop, const std::vector<double>& arrivals, const std::vector<Parent>& parents) const
+	{
+		if (arrivals[to_stop] == INFINITE_TIME) {
+			return std::nullopt;
+		}
+
+		Journey journey;
+		journey.to_stop = to_stop;
+		size_t stop = to_stop;
+		while (parents[stop].pattern != NO_POSITION) {
+			if (journey.legs.size() > stop_count_) {
+				throw std::logic_error("Journey does not lead to the start stop");
+			}
+			const Parent& parent = parents[stop];
+			const Pattern& pattern = patterns_[parent.pattern];
+			journey.legs.push_back({ pattern.stops[parent.board_position], pattern.bus
+				, static_cast<int>(parent.alight_position - parent.board_position)
+				, (pattern.distances[parent.alight_position] - pattern.distances[parent.board_position]) / velocity_ });
+			stop = pattern.stops[parent.board_position];
+		}
+		journey.from_stop = stop;
+		std::reverse(journey.legs.begin(), journey.legs.end());
+		for (const Leg& leg : journey.legs) {
+			journey.total_time += wait_time_;
+			journey.total_time += leg.ride_time;
+		}
+		return journey;
+	}
+
+	std::vector<std::optional<double>> RaptorRouter::ComputeArrivalTimes(size_t from_stop, double max_time) const
+	{
+		if (from_stop >= stop_count_) {
+			throw std::out_of_range("Stop is out of router");
+		}
+
+		std::vector<double> arrivals;
+		std::vector<Parent> parents;
+		Search({ { from_stop, 0 } }, {}, max_time, arrivals, parents);
+		std::vector<std::optional<double>> result(stop_count_);
+		for (size_t stop = 0; stop < stop_count_; ++stop) {
+			if (arrivals[stop] != INFINITE_TIME) {
+				result[stop] = arrivals[stop];
+			}
+		}
+		return result;
+	}
+
+	void RaptorRouter::Search(const std::vector<StopTime>& from_stops, const std::vector<StopTime>& to_stops, double max_time
+		, std::vector<double>& arrivals, std::vector<Parent>& parents) const
+	{
+		arrivals.assign(stop_count_, INFINITE_TIME);
+		parents.assign(stop_count_, { NO_POSITION, NO_POSITION, NO_POSITION });
+		std::vector<bool> is_marked(stop_count_, false);
+		std::vector<uint32_t> marked_stops;
+		std::vector<uint32_t> earliest_positions(patterns_.size(), NO_POSITION);
+		std::vector<uint32_t> scanned_patterns;
+
+		// Time left after arriving at every end stop and the best arrival at the destination through one of them
+		std::vector<double> end_times(to_stops.empty() ? 0 : stop_count_, INFINITE_TIME);
+		for (const StopTime& to_stop : to_stops) {
+			end_times[to_stop.stop] = std::min(end_times[to_stop.stop], to_stop.time);
+		}
+		double best_end_arrival = INFINITE_TIME;
+		const auto arrive = [&](uint32_t stop, double arrival) {
+			arrivals[stop] = arrival;
+			if (!end_times.empty()) {
+				best_end_arrival = std::min(best_end_arrival, arrival + end_times[stop]);
+			}
+			if (!is_marked[stop]) {
+				is_marked[stop] = true;
+				marked_stops.push_back(stop);
+			}
+		};
+		for (const StopTime& from_stop : from_stops) {
+			if (from_stop.time < arrivals[from_stop.stop]) {
+				arrive(static_cast<uint32_t>(from_stop.stop), from_stop.time);
+			}
+		}
+
+		while (!marked_stops.empty()) {
+			// A pattern is scanned from its earliest improved stop: nothing before it has changed
+			for (const uint32_t stop : marked_stops) {
+				is_marked[stop] = false;
+				for (uint32_t i = stop_pattern_offsets_[stop]; i < stop_pattern_offsets_[stop + 1]; ++i) {
+					const auto [pattern, position] = stop_patterns_[i];
+					if (earliest_positions[pattern] == NO_POSITION) {
+						scanned_patterns.push_back(pattern);
+					}
+					earliest_positions[pattern] = std::min(earliest_positions[pattern], position);
+				}
+			}
+			marked_stops.clear();
+
+			for (const uint32_t pattern_id : scanned_patterns) {
+				const Pattern& pattern = patterns_[pattern_id];
+				uint32_t board_position = NO_POSITION;
+				double board_time = 0;		// arrival at the board stop plus waiting
+				double board_key = 0;		// board time minus the time to ride to the board stop
+				for (uint32_t position = earliest_positions[pattern_id]; position < pattern.stops.size(); ++position) {
+					const uint32_t stop = pattern.stops[position];
+					if (board_position != NO_POSITION) {
+						const double arrival = board_time + (pattern.distances[position] - pattern.distances[board_position]) / velocity_;
+						// No journey through a stop reached later than the destination can improve the destination
+						if (arrival < arrivals[stop] && arrival <= max_time && arrival < best_end_arrival) {
+							parents[stop] = { pattern_id, board_position, position };
+							arrive(stop, arrival);
+						}
+					}
+					if (arrivals[stop] != INFINITE_TIME) {
+						const double key = arrivals[stop] + wait_time_ - pattern.distances[position] / velocity_;
+						if (board_position == NO_POSITION || key < board_key) {
+							board_position = position;
+							board_time = arrivals[stop] + wait_time_;
+							board_key = key;
+						}
+					}
+				}
+				earliest_positions[pattern_id] = NO_POSITION;
+			}
+			scanned_patterns.clear();
+		}
+	}
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "transport_catalogue.h"
+
+namespace transport_router {
+
+	// Round-based public transit search (RAPTOR-like) straight over Bus::stops.
+	// Every round scans each bus passing a stop improved in the previous round, once,
+	// from that stop onwards, boarding at the stop with the best arrival seen so far.
+	// Memory is linear in the total length of the routes, there is no edge for every
+	// pair of stops of a bus.
+	class RaptorRouter {
+	public:
+		using TransportCatalogue = transport_catalogue::data_base::TransportCatalogue;
+		using Bus = transport_catalogue::data_base::Bus;
+
+		// One ride of a journey, preceded by waiting for the bus at board_stop
+		struct Leg
+		{
+			uint32_t board_stop = 0;
+			const Bus* bus = nullptr;
+			int span_count = 0;
+			double ride_time = 0;
+		};
+
+		struct Journey
+		{
+			double total_time = 0;
+			std::vector<Leg> legs;
+			// Stops the journey starts and ends at
+			size_t from_stop = 0;
+			size_t to_stop = 0;
+		};
+
+		// Stop a search may start or end at and the time spent before arriving at it or after leaving it
+		struct StopTime
+		{
+			size_t stop = 0;
+			double time = 0;
+		};
+
+		RaptorRouter(const TransportCatalogue& tc, int bus_wait_time, double bus_velocity);
+
+		// Stops are numbered by their catalogue ids
+		std::optional<Journey> BuildRoute(size_t from_stop, size_t to_stop) const;
+		// Journeys from one stop to each of the given stops, found by a single search
+		std::vector<std::optional<Journey>> BuildRoutes(size_t from_stop, const std::vector<size_t>& to_stops) const;
+		// Fastest journey from one of the start stops to one of the end stops, counting the times of both.
+		// Their times are not part of the journey's total time. Found by a single search from all the start stops
+		std::optional<Journey> BuildRoute(const std::vector<StopTime>& from_stops, const std::vector<StopTime>& to_stops) const;
+		// Earliest arrival at every stop from one stop, found by a single search. Stops reached
+		// later than max_time are left empty and the search does not go on from them
+		std::vector<std::optional<double>> ComputeArrivalTimes(size_t from_stop
+			, double max_time = std::numeric_limits<double>::infinity()) const;
+
+	private:
+		// Part of a bus route ridden without leaving the bus: the whole route of a circle bus,
+		// either half of a two-directional one
+		struct Pattern
+		{
+			const Bus* bus = nullptr;
+			std::vector<uint32_t> stops;
+			// Road distance from the first stop of the pattern
+			std::vector<double> distances;
+		};
+
+		// Pattern passing a stop and the position of the stop in it
+		struct StopPattern
+		{
+			uint32_t pattern;
+			uint32_t position;
+		};
+
+		// Last ride of the best known journey to a stop
+		struct Parent
+		{
+			uint32_t pattern;
+			uint32_t board_position;
+			uint32_t alight_position;
+		};
+
+		// Pattern of the stops at positions [begin, end) of the route
+		void AddPattern(const Bus& bus, size_t begin, size_t end);
+		// Fills arrivals and their last rides from the start stops, arriving at each of them at its time.
+		// With end stops, prunes everything that cannot beat the best arrival at an end stop plus its time,
+		// and everything reached later than max_time
+		void Search(const std::vector<StopTime>& from_stops, const std::vector<StopTime>& to_stops, double max_time
+			, std::vector<double>& arrivals, std::vector<Parent>& parents) const;
+		// Follows the last rides back from the stop to a start stop, which has none
+		std::optional<Journey> MakeJourney(size_t to_stop, const std::vector<double>& arrivals, const std::vector<Parent>& parents) const;
+
+		double wait_time_;
+		double velocity_;		// m/min
+		size_t stop_count_ = 0;
+		std::vector<Pattern> patterns_;
+		// Patterns passing every stop, compressed by stop
+		std::vector<uint32_t> stop_pattern_offsets_;
+		std::vector<StopPattern> stop_patterns_;
+	};
+}
@@ -14,15 +14,51 @@ namespace handler {
 		return db_.GetStopInfo(stop_name);
 	}
 
+	std::string_view RequestHandler::GetBusName(uint32_t bus_id) const
+	{
+		return db_.GetBuses().at(bus_id).name;
+	}
+
+	std::vector<transport_catalogue::data_base::NearbyStop> RequestHandler::FindNearestStops(geo::Coordinates point, size_t max_count, double max_distance) const
+	{
+		return db_.FindNearestStops(point, max_count, max_distance);
+	}
+
 	const svg::Document& RequestHandler::RenderMap() const
 	{
 		return renderer_.GetDocument();
 	}
 
-	std::optional<graph::Router<double>::RouteInfo> RequestHandler::BuildRoute(const std::string& from, const std::string& to) const
+	std::optional<transport_router::RouteInfo> RequestHandler::BuildRoute(const std::string& from, const std::string& to) const
 	{
 		return router_.BuildRoute(from, to);	
 	}
+
+	std::optional<transport_router::RouteInfo> RequestHandler::BuildRoute(const transport_router::RouteEndpoint& from, const transport_router::RouteEndpoint& to) const
+	{
+		return router_.BuildRoute(from, to);
+	}
+
+	std::vector<transport_router::RouteInfo> RequestHandler::BuildAlternativeRoutes(const std::string& from, const std::string& to, size_t max_count
+		, std::optional<std::chrono::milliseconds> latency_budget) const
+	{
+		return router_.BuildAlternativeRoutes(from, to, max_count, latency_budget);
+	}
+
+	std::vector<std::optional<transport_router::RouteInfo>> RequestHandler::BuildRoutesFrom(const std::string& from, const std::vector<std::string>& targets) const
+	{
+		return router_.BuildRoutesFrom(from, targets);
+	}
+
+	transport_router::TransportRouter::TimeMatrix RequestHandler::BuildRoutes(const std::vector<std::string>& sources, const std::vector<std::string>& targets) const
+	{
+		return router_.BuildRoutes(sources, targets);
+	}
+
+	std::vector<transport_router::ReachableStop> RequestHandler::BuildReachableStops(const std::string& from, double max_time) const
+	{
+		return router_.BuildReachableStops(from, max_time);
+	}
     
     std::pair<const graph::Edge<double>&, const transport_router::EdgeInfo&> RequestHandler::GetFullEdgeInfo(graph::EdgeId edge_id) const {
         return router_.GetFullEdgeInfo(edge_id);
@@ -15,8 +15,16 @@ namespace handler {
 
         transport_catalogue::data_base::BusInfo GetBusInfo(const std::string_view& bus_name) const;
         transport_catalogue::data_base::StopInfo GetStopInfo(const std::string_view& stop_name) const;
+        std::string_view GetBusName(uint32_t bus_id) const;
+        std::vector<transport_catalogue::data_base::NearbyStop> FindNearestStops(geo::Coordinates point, size_t max_count, double max_distance) const;
         const svg::Document& RenderMap() const;
-        std::optional<graph::Router<double>::RouteInfo> BuildRoute(const std::string& from, const std::string& to) const;
+        std::optional<transport_router::RouteInfo> BuildRoute(const std::string& from, const std::string& to) const;
+        std::optional<transport_router::RouteInfo> BuildRoute(const transport_router::RouteEndpoint& from, const transport_router::RouteEndpoint& to) const;
+        std::vector<transport_router::RouteInfo> BuildAlternativeRoutes(const std::string& from, const std::string& to, size_t max_count
+            , std::optional<std::chrono::milliseconds> latency_budget) const;
+        std::vector<std::optional<transport_router::RouteInfo>> BuildRoutesFrom(const std::string& from, const std::vector<std::string>& targets) const;
+        transport_router::TransportRouter::TimeMatrix BuildRoutes(const std::vector<std::string>& sources, const std::vector<std::string>& targets) const;
+        std::vector<transport_router::ReachableStop> BuildReachableStops(const std::string& from, double max_time) const;
         std::pair<const graph::Edge<double>&, const transport_router::EdgeInfo&> GetFullEdgeInfo(graph::EdgeId edge_id) const;
 	
 
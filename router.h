@@ -1,6 +1,7 @@
 #pragma once
 
 #include "graph.h"
+#include "routes_storage.h"
 
 #include <algorithm>
 #include <cassert>
@@ -14,62 +15,97 @@
 
 namespace graph {
 
+// Common interface of the route search engines built over DirectedWeightedGraph
 template <typename Weight>
-class Router {
-private:
-    using Graph = DirectedWeightedGraph<Weight>;
-
+class RoutingEngine {
 public:
-    explicit Router(const Graph& graph);
-
     struct RouteInfo {
         Weight weight;
         std::vector<EdgeId> edges;
     };
 
-    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    virtual ~RoutingEngine() = default;
+    virtual std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const = 0;
+};
 
+// Precomputes routes between all pairs of vertices (Floyd-Warshall) and answers
+// queries from the table. Storage selects the table layout, see routes_storage.h
+template <typename Weight, typename Storage = NestedRoutesStorage<Weight>>
+class Router final : public RoutingEngine<Weight> {
 private:
-    struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
-    };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename RoutingEngine<Weight>::RouteInfo;
+    using RoutesInternalData = Storage;
+
+    explicit Router(const Graph& graph);
+    // Runs the all-pairs pass on thread_count threads, gives the same table as the single-threaded one
+    Router(const Graph& graph, size_t thread_count);
+    // Restores a router from a previously computed table, skipping the all-pairs pass
+    Router(const Graph& graph, RoutesInternalData routes_internal_data);
 
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    const RoutesInternalData& GetRoutesInternalData() const;
+
+private:
     void InitializeRoutesInternalData(const Graph& graph) {
         const size_t vertex_count = graph.GetVertexCount();
         for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+            routes_internal_data_.SetRoute(vertex, vertex, ZERO_WEIGHT, std::nullopt);
             for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                 const auto& edge = graph.GetEdge(edge_id);
                 if (edge.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                if (!routes_internal_data_.HasRoute(vertex, edge.to)
+                    || routes_internal_data_.GetWeight(vertex, edge.to) > edge.weight) {
+                    routes_internal_data_.SetRoute(vertex, edge.to, edge.weight, edge_id);
                 }
             }
         }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
-        }
-    }
-
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
+    // BuildRoute follows prev edges without bounds checks, so a restored table must have every
+    // chain of prev edges end at the origin of its row
+    void CheckRoutesInternalData() const {
+        enum class ChainState : uint8_t { UNCHECKED, ON_CHAIN, REACHES_FROM };
+        const size_t vertex_count = graph_.GetVertexCount();
+        const size_t edge_count = graph_.GetEdgeCount();
+        std::vector<ChainState> states(vertex_count);
+        std::vector<VertexId> chain;
+        for (VertexId from = 0; from < vertex_count; ++from) {
+            std::fill(states.begin(), states.end(), ChainState::UNCHECKED);
+            for (VertexId to = 0; to < vertex_count; ++to) {
+                if (!routes_internal_data_.HasRoute(from, to)) {
+                    continue;
+                }
+                chain.clear();
+                VertexId vertex = to;
+                while (states[vertex] == ChainState::UNCHECKED) {
+                    if (!routes_internal_data_.HasRoute(from, vertex)) {
+                        throw std::invalid_argument("Routes internal data does not match the graph");
+                    }
+                    states[vertex] = ChainState::ON_CHAIN;
+                    chain.push_back(vertex);
+                    const std::optional<EdgeId> prev_edge = routes_internal_data_.GetPrevEdge(from, vertex);
+                    if (!prev_edge) {
+                        if (vertex != from) {
+                            throw std::invalid_argument("Routes internal data does not match the graph");
+                        }
+                        states[vertex] = ChainState::REACHES_FROM;
+                        break;
                     }
+                    if (*prev_edge >= edge_count || graph_.GetEdge(*prev_edge).to != vertex) {
+                        throw std::invalid_argument("Routes internal data does not match the graph");
+                    }
+                    vertex = graph_.GetEdge(*prev_edge).from;
+                }
+                if (states[vertex] == ChainState::ON_CHAIN) {
+                    throw std::invalid_argument("Routes internal data does not match the graph");
+                }
+                for (const VertexId chain_vertex : chain) {
+                    states[chain_vertex] = ChainState::REACHES_FROM;
                 }
             }
         }
@@ -80,37 +116,68 @@ private:
     RoutesInternalData routes_internal_data_;
 };
 
-template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+template <typename Weight, typename Storage>
+Router<Weight, Storage>::Router(const Graph& graph)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , routes_internal_data_(graph.GetVertexCount())
 {
     InitializeRoutesInternalData(graph);
 
     const size_t vertex_count = graph.GetVertexCount();
     for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+        routes_internal_data_.RelaxThroughVertex(vertex_through);
     }
 }
 
-template <typename Weight>
-std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
-                                                                             VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+template <typename Weight, typename Storage>
+Router<Weight, Storage>::Router(const Graph& graph, size_t thread_count)
+    : graph_(graph)
+    , routes_internal_data_(graph.GetVertexCount())
+{
+    InitializeRoutesInternalData(graph);
+    routes_internal_data_.RelaxThroughAllVertices(thread_count);
+}
+
+template <typename Weight, typename Storage>
+Router<Weight, Storage>::Router(const Graph& graph, RoutesInternalData routes_internal_data)
+    : graph_(graph)
+    , routes_internal_data_(std::move(routes_internal_data))
+{
+    if (routes_internal_data_.GetVertexCount() != graph.GetVertexCount()) {
+        throw std::invalid_argument("Routes internal data does not match the graph");
+    }
+    CheckRoutesInternalData();
+}
+
+template <typename Weight, typename Storage>
+const typename Router<Weight, Storage>::RoutesInternalData& Router<Weight, Storage>::GetRoutesInternalData() const {
+    return routes_internal_data_;
+}
+
+template <typename Weight, typename Storage>
+std::optional<typename Router<Weight, Storage>::RouteInfo> Router<Weight, Storage>::BuildRoute(VertexId from,
+                                                                                               VertexId to) const {
+    if (!routes_internal_data_.HasRoute(from, to)) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
+    Weight weight = routes_internal_data_.GetWeight(from, to);
     std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
+    for (std::optional<EdgeId> edge_id = routes_internal_data_.GetPrevEdge(from, to);
          edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+         edge_id = routes_internal_data_.GetPrevEdge(from, graph_.GetEdge(*edge_id).from))
     {
         edges.push_back(*edge_id);
     }
     std::reverse(edges.begin(), edges.end());
 
+    if constexpr (!Storage::HAS_EXACT_WEIGHTS) {
+        // A narrowed table only orders the routes, the answer is summed over the original edges
+        weight = ZERO_WEIGHT;
+        for (const EdgeId edge_id : edges) {
+            weight += graph_.GetEdge(edge_id).weight;
+        }
+    }
+
     return RouteInfo{weight, std::move(edges)};
 }
 
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "astar_router.h"
+#include "dijkstra_router.h"
+#include "router.h"
+
+using namespace std::literals;
+
+// Compares the single-threaded and the blocked multi-threaded all-pairs passes of graph::Router
+// on random graphs and checks that both give bit-identical tables. Also cross-checks the
+// on-demand engines (Dijkstra, bidirectional A*) against the table on random queries.
+// Usage: router_benchmark [vertex_count ...] [--threads N] [--edges-per-vertex M] [--queries Q]
+
+namespace {
+    using RoutesStorage = graph::FlatRoutesStorage<double>;
+    using FlatRouter = graph::Router<double, RoutesStorage>;
+
+    struct Point {
+        double x;
+        double y;
+    };
+
+    double ComputeDistance(Point from, Point to) {
+        return std::hypot(from.x - to.x, from.y - to.y);
+    }
+
+    // Vertices are random points on a plane, an edge is never lighter than the distance
+    // between its ends, so the distance is a consistent lower bound for A*
+    graph::DirectedWeightedGraph<double> MakeRandomGraph(size_t vertex_count, size_t edges_per_vertex, std::mt19937& generator,
+                                                         std::vector<Point>& points) {
+        graph::DirectedWeightedGraph<double> graph(vertex_count);
+        std::uniform_real_distribution<double> coordinate_distribution(0., 60.);
+        points.resize(vertex_count);
+        for (Point& point : points) {
+            point = { coordinate_distribution(generator), coordinate_distribution(generator) };
+        }
+        std::uniform_int_distribution<size_t> vertex_distribution(0, vertex_count - 1);
+        std::uniform_real_distribution<double> detour_distribution(1., 3.);
+        for (size_t i = 0; i < vertex_count * edges_per_vertex; ++i) {
+            const size_t from = vertex_distribution(generator);
+            const size_t to = vertex_distribution(generator);
+            graph.AddEdge({ from, to, 1. + ComputeDistance(points[from], points[to]) * detour_distribution(generator) });
+        }
+        graph.Freeze();
+        return graph;
+    }
+
+    // Counts random queries where the engine disagrees with the table
+    size_t CountMismatches(const graph::RoutingEngine<double>& engine, const FlatRouter& router,
+                           const graph::DirectedWeightedGraph<double>& graph, size_t query_count, std::mt19937& generator) {
+        std::uniform_int_distribution<size_t> vertex_distribution(0, graph.GetVertexCount() - 1);
+        size_t mismatch_count = 0;
+        for (size_t i = 0; i < query_count; ++i) {
+            const size_t from = vertex_distribution(generator);
+            const size_t to = vertex_distribution(generator);
+            const auto expected = router.BuildRoute(from, to);
+            const auto actual = engine.BuildRoute(from, to);
+            if (expected.has_value() != actual.has_value()) {
+                ++mismatch_count;
+                continue;
+            }
+            if (!expected) {
+                continue;
+            }
+            // Equal routes may differ in edges, and their weights in the summation order
+            double path_weight = 0.;
+            graph::VertexId vertex = from;
+            bool is_connected = true;
+            for (const graph::EdgeId edge_id : actual->edges) {
+                const auto& edge = graph.GetEdge(edge_id);
+                is_connected = is_connected && edge.from == vertex;
+                vertex = edge.to;
+                path_weight += edge.weight;
+            }
+            if (!is_connected || vertex != to || std::abs(path_weight - actual->weight) > 1e-9 * (1. + path_weight)
+                || std::abs(expected->weight - actual->weight) > 1e-9 * (1. + expected->weight)) {
+                ++mismatch_count;
+            }
+        }
+        return mismatch_count;
+    }
+
+    bool IsSameTable(const RoutesStorage& lhs, const RoutesStorage& rhs) {
+        const size_t vertex_count = lhs.GetVertexCount();
+        for (graph::VertexId from = 0; from < vertex_count; ++from) {
+            for (graph::VertexId to = 0; to < vertex_count; ++to) {
+                if (lhs.HasRoute(from, to) != rhs.HasRoute(from, to)) {
+                    return false;
+                }
+                if (!lhs.HasRoute(from, to)) {
+                    continue;
+                }
+                const double lhs_weight = lhs.GetWeight(from, to);
+                const double rhs_weight = rhs.GetWeight(from, to);
+                if (std::memcmp(&lhs_weight, &rhs_weight, sizeof(double)) != 0
+                    || lhs.GetPrevEdge(from, to) != rhs.GetPrevEdge(from, to)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    template <typename Builder>
+    double MeasureSeconds(Builder builder) {
+        const auto start = std::chrono::steady_clock::now();
+        builder();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<size_t> vertex_counts;
+    size_t thread_count = std::max(1u, std::thread::hardware_concurrency());
+    size_t edges_per_vertex = 4;
+    size_t query_count = 1000;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg(argv[i]);
+        if (arg == "--threads"sv && i + 1 < argc) {
+            thread_count = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--edges-per-vertex"sv && i + 1 < argc) {
+            edges_per_vertex = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--queries"sv && i + 1 < argc) {
+            query_count = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            vertex_counts.push_back(std::strtoul(argv[i], nullptr, 10));
+        }
+    }
+    if (vertex_counts.empty()) {
+        vertex_counts = { 500, 1000, 2000 };
+    }
+
+    std::mt19937 generator(42);
+    bool all_identical = true;
+    for (const size_t vertex_count : vertex_counts) {
+        std::vector<Point> points;
+        const auto graph = MakeRandomGraph(vertex_count, edges_per_vertex, generator, points);
+        std::unique_ptr<FlatRouter> sequential;
+        std::unique_ptr<FlatRouter> blocked;
+        const double sequential_seconds = MeasureSeconds([&] { sequential = std::make_unique<FlatRouter>(graph); });
+        const double blocked_seconds = MeasureSeconds([&] { blocked = std::make_unique<FlatRouter>(graph, thread_count); });
+        const bool is_identical = IsSameTable(sequential->GetRoutesInternalData(), blocked->GetRoutesInternalData());
+        all_identical = all_identical && is_identical;
+
+        std::cout << "vertices: "sv << vertex_count
+            << ", sequential: "sv << sequential_seconds << " s"sv
+            << ", blocked (threads: "sv << thread_count << "): "sv << blocked_seconds << " s"sv
+            << ", speedup: "sv << sequential_seconds / blocked_seconds
+            << ", identical: "sv << (is_identical ? "yes"sv : "NO"sv) << '\n';
+
+        const graph::DijkstraRouter<double> dijkstra(graph);
+        const graph::AStarRouter<double> astar(graph, [&points](graph::VertexId from, graph::VertexId to) {
+            return ComputeDistance(points[from], points[to]);
+        });
+        const size_t dijkstra_mismatch_count = CountMismatches(dijkstra, *sequential, graph, query_count, generator);
+        const size_t astar_mismatch_count = CountMismatches(astar, *sequential, graph, query_count, generator);
+        all_identical = all_identical && dijkstra_mismatch_count == 0 && astar_mismatch_count == 0;
+
+        std::cout << "    queries: "sv << query_count
+            << ", dijkstra mismatches: "sv << dijkstra_mismatch_count
+            << ", astar mismatches: "sv << astar_mismatch_count << '\n';
+    }
+    return all_identical ? 0 : 1;
+}
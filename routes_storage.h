@@ -0,0 +1,176 @@
+#pragma once
+
+#include "floyd_warshall.h"
+#include "graph.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace graph {
+
+// Storage policies for the all-pairs routes table of graph::Router.
+// Each policy keeps, for every (from, to) pair, the weight of the best known route
+// and the last edge of that route, and relaxes the whole table through one vertex.
+
+// Original layout: a vector of rows of optional cells.
+template <typename Weight>
+class NestedRoutesStorage {
+public:
+    struct RouteInternalData {
+        Weight weight;
+        std::optional<EdgeId> prev_edge;
+    };
+    static constexpr bool HAS_EXACT_WEIGHTS = true;
+
+    NestedRoutesStorage() = default;
+    explicit NestedRoutesStorage(size_t vertex_count)
+        : routes_internal_data_(vertex_count, std::vector<std::optional<RouteInternalData>>(vertex_count)) {
+    }
+
+    size_t GetVertexCount() const {
+        return routes_internal_data_.size();
+    }
+    bool HasRoute(VertexId from, VertexId to) const {
+        return routes_internal_data_.at(from).at(to).has_value();
+    }
+    Weight GetWeight(VertexId from, VertexId to) const {
+        return routes_internal_data_[from][to]->weight;
+    }
+    std::optional<EdgeId> GetPrevEdge(VertexId from, VertexId to) const {
+        return routes_internal_data_[from][to]->prev_edge;
+    }
+    void SetRoute(VertexId from, VertexId to, Weight weight, std::optional<EdgeId> prev_edge) {
+        routes_internal_data_[from][to] = RouteInternalData{weight, prev_edge};
+    }
+
+    void RelaxThroughVertex(VertexId vertex_through) {
+        const size_t vertex_count = GetVertexCount();
+        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
+            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
+                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
+                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
+                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
+                    const RouteInternalData& route_to) {
+        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
+        const Weight candidate_weight = route_from.weight + route_to.weight;
+        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
+            route_relaxing = {candidate_weight,
+                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+        }
+    }
+
+    std::vector<std::vector<std::optional<RouteInternalData>>> routes_internal_data_;
+};
+
+// Compact layout: two contiguous row-major V x V arrays, one of weights and one of
+// 32-bit predecessor edges. Absence of a route and of a predecessor are encoded
+// with sentinel edge ids. StoredWeight may be narrower than Weight (e.g. float)
+// to halve the weights array at the cost of precision.
+template <typename Weight, typename StoredWeight = Weight>
+class FlatRoutesStorage {
+public:
+    static constexpr uint32_t NO_ROUTE = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t NO_EDGE = NO_ROUTE - 1;
+    static constexpr size_t MAX_EDGE_COUNT = NO_EDGE;
+    static constexpr bool HAS_EXACT_WEIGHTS = std::is_same_v<Weight, StoredWeight>;
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64;
+
+    FlatRoutesStorage() = default;
+    explicit FlatRoutesStorage(size_t vertex_count)
+        : vertex_count_(vertex_count)
+        , weights_(vertex_count * vertex_count, INFINITE_WEIGHT)
+        , prev_edges_(vertex_count * vertex_count, NO_ROUTE) {
+    }
+
+    size_t GetVertexCount() const {
+        return vertex_count_;
+    }
+    bool HasRoute(VertexId from, VertexId to) const {
+        if (from >= vertex_count_ || to >= vertex_count_) {
+            throw std::out_of_range("Vertex is out of routes storage");
+        }
+        return prev_edges_[Index(from, to)] != NO_ROUTE;
+    }
+    Weight GetWeight(VertexId from, VertexId to) const {
+        return static_cast<Weight>(weights_[Index(from, to)]);
+    }
+    std::optional<EdgeId> GetPrevEdge(VertexId from, VertexId to) const {
+        const uint32_t prev_edge = prev_edges_[Index(from, to)];
+        if (prev_edge == NO_EDGE) {
+            return std::nullopt;
+        }
+        return prev_edge;
+    }
+    void SetRoute(VertexId from, VertexId to, Weight weight, std::optional<EdgeId> prev_edge) {
+        if (prev_edge && *prev_edge >= MAX_EDGE_COUNT) {
+            throw std::out_of_range("Edge id does not fit into 32-bit routes storage");
+        }
+        weights_[Index(from, to)] = static_cast<StoredWeight>(weight);
+        prev_edges_[Index(from, to)] = prev_edge ? static_cast<uint32_t>(*prev_edge) : NO_EDGE;
+    }
+
+    void RelaxThroughVertex(VertexId vertex_through) {
+        const StoredWeight* weights_through = &weights_[Index(vertex_through, 0)];
+        const uint32_t* prev_edges_through = &prev_edges_[Index(vertex_through, 0)];
+        for (VertexId vertex_from = 0; vertex_from < vertex_count_; ++vertex_from) {
+            const size_t cell_from = Index(vertex_from, vertex_through);
+            const uint32_t prev_edge_from = prev_edges_[cell_from];
+            if (prev_edge_from == NO_ROUTE) {
+                continue;
+            }
+            const Weight weight_from = weights_[cell_from];
+            StoredWeight* weights_row = &weights_[Index(vertex_from, 0)];
+            uint32_t* prev_edges_row = &prev_edges_[Index(vertex_from, 0)];
+            if constexpr (std::is_floating_point_v<StoredWeight>) {
+                floyd_warshall::RelaxRow<Weight, StoredWeight>(weights_row, prev_edges_row, weight_from, prev_edge_from,
+                                                               weights_through, prev_edges_through, vertex_count_, NO_EDGE);
+                continue;
+            }
+            for (VertexId vertex_to = 0; vertex_to < vertex_count_; ++vertex_to) {
+                const uint32_t prev_edge_to = prev_edges_through[vertex_to];
+                if (prev_edge_to == NO_ROUTE) {
+                    continue;
+                }
+                const Weight candidate_weight = weight_from + weights_through[vertex_to];
+                if (prev_edges_row[vertex_to] == NO_ROUTE || candidate_weight < weights_row[vertex_to]) {
+                    weights_row[vertex_to] = static_cast<StoredWeight>(candidate_weight);
+                    prev_edges_row[vertex_to] = prev_edge_to != NO_EDGE ? prev_edge_to : prev_edge_from;
+                }
+            }
+        }
+    }
+
+    // Relaxes the table through all vertices with the multi-threaded blocked pass.
+    // Gives the same table as calling RelaxThroughVertex for every vertex in order.
+    void RelaxThroughAllVertices(size_t thread_count, size_t block_size = DEFAULT_BLOCK_SIZE) {
+        floyd_warshall::RunBlocked<Weight, StoredWeight>(weights_.data(), prev_edges_.data(), vertex_count_,
+                                                         NO_ROUTE, NO_EDGE, thread_count, block_size);
+    }
+
+private:
+    static constexpr StoredWeight INFINITE_WEIGHT = std::numeric_limits<StoredWeight>::has_infinity
+        ? std::numeric_limits<StoredWeight>::infinity()
+        : std::numeric_limits<StoredWeight>::max();
+
+    size_t Index(VertexId from, VertexId to) const {
+        return from * vertex_count_ + to;
+    }
+
+    size_t vertex_count_ = 0;
+    std::vector<StoredWeight> weights_;
+    std::vector<uint32_t> prev_edges_;
+};
+
+}  // namespace graph
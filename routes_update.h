@@ -0,0 +1,117 @@
+#pragma once
+
+#include "dijkstra_router.h"
+#include "floyd_warshall.h"
+#include "graph.h"
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace graph {
+
+// How the edges of a graph relate to the edges of its previous version
+struct GraphChange {
+    // Current id of every previous edge, empty for an edge that is gone
+    std::vector<std::optional<EdgeId>> edge_ids;
+    // Current edges the previous version had no match for
+    std::vector<EdgeId> added_edges;
+};
+
+// Fills the row of the tree's root from a shortest path tree over the graph
+template <typename Weight, typename Storage>
+void SetRoutesFromTree(const ShortestPathTree<Weight>& tree, size_t vertex_count, Storage& data) {
+    for (VertexId to = 0; to < vertex_count; ++to) {
+        if (const auto weight = tree.GetWeight(to)) {
+            data.SetRoute(tree.GetRoot(), to, *weight, tree.GetLastEdge(to));
+        }
+    }
+}
+
+// Computes an all-pairs routes table with a Dijkstra search per row. On a sparse graph it is
+// faster than the Floyd-Warshall pass, O(V E log V) against O(V^3)
+template <typename Weight, typename Storage>
+Storage ComputeRoutesInternalData(const DirectedWeightedGraph<Weight>& graph, size_t thread_count) {
+    const size_t vertex_count = graph.GetVertexCount();
+    Storage data(vertex_count);
+    floyd_warshall::ParallelFor(vertex_count, thread_count, [&](size_t from) {
+        SetRoutesFromTree(ShortestPathTree<Weight>(graph, from), vertex_count, data);
+    });
+    return data;
+}
+
+// Brings an all-pairs routes table computed for the previous version of a graph up to
+// date, without the full Floyd-Warshall pass. Vertices may only be appended.
+//
+// A row whose shortest path tree used no removed edge stays optimal without those edges,
+// so it is only renumbered; other rows and rows of new vertices are recomputed by Dijkstra.
+// Then every route through added edges is made of old routes and added edges joined at
+// their end vertices, so relaxing the table through these vertices only is enough.
+// Costs O(V^2) for the check, a Dijkstra search per stale row and O(V^2) per end vertex.
+template <typename Weight, typename Storage>
+Storage UpdateRoutesInternalData(const DirectedWeightedGraph<Weight>& graph, const Storage& previous_data,
+                                 const GraphChange& change, size_t thread_count) {
+    const size_t vertex_count = graph.GetVertexCount();
+    const size_t previous_vertex_count = previous_data.GetVertexCount();
+    if (previous_vertex_count > vertex_count) {
+        throw std::invalid_argument("Vertices cannot be removed from routes internal data");
+    }
+
+    const auto current_edge_id = [&](EdgeId previous_edge_id) -> std::optional<EdgeId> {
+        if (previous_edge_id >= change.edge_ids.size()) {
+            throw std::out_of_range("Routes internal data refers to an unknown edge");
+        }
+        return change.edge_ids[previous_edge_id];
+    };
+
+    // char rather than bool: rows are marked from several threads
+    std::vector<char> is_stale(vertex_count, 1);
+    floyd_warshall::ParallelFor(previous_vertex_count, thread_count, [&](size_t from) {
+        for (VertexId to = 0; to < previous_vertex_count; ++to) {
+            if (!previous_data.HasRoute(from, to)) {
+                continue;
+            }
+            const auto prev_edge = previous_data.GetPrevEdge(from, to);
+            if (prev_edge && !current_edge_id(*prev_edge)) {
+                return;
+            }
+        }
+        is_stale[from] = 0;
+    });
+
+    Storage data(vertex_count);
+    floyd_warshall::ParallelFor(vertex_count, thread_count, [&](size_t from) {
+        if (!is_stale[from]) {
+            for (VertexId to = 0; to < previous_vertex_count; ++to) {
+                if (!previous_data.HasRoute(from, to)) {
+                    continue;
+                }
+                const auto prev_edge = previous_data.GetPrevEdge(from, to);
+                data.SetRoute(from, to, previous_data.GetWeight(from, to),
+                              prev_edge ? current_edge_id(*prev_edge) : std::nullopt);
+            }
+            return;
+        }
+        SetRoutesFromTree(ShortestPathTree<Weight>(graph, from), vertex_count, data);
+    });
+
+    std::vector<VertexId> end_vertices;
+    end_vertices.reserve(change.added_edges.size() * 2);
+    for (const EdgeId edge_id : change.added_edges) {
+        const auto& edge = graph.GetEdge(edge_id);
+        if (!data.HasRoute(edge.from, edge.to) || edge.weight < data.GetWeight(edge.from, edge.to)) {
+            data.SetRoute(edge.from, edge.to, edge.weight, edge_id);
+        }
+        end_vertices.push_back(edge.from);
+        end_vertices.push_back(edge.to);
+    }
+    std::sort(end_vertices.begin(), end_vertices.end());
+    end_vertices.erase(std::unique(end_vertices.begin(), end_vertices.end()), end_vertices.end());
+    for (const VertexId vertex : end_vertices) {
+        data.RelaxThroughVertex(vertex);
+    }
+    return data;
+}
+
+}  // namespace graph
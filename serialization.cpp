@@ -11,54 +11,61 @@ namespace Serialization {
         SerializeStops(db, proto_db);
         SerializeBuses(db, proto_db);
         SerializeDistances(db, proto_db);
+        *proto_db.mutable_stop_grid() = SerializeStopGrid(db.GetStopGrid());
         SerializeRenderSettings(render_settings, proto_db);
         SerializeTransportRouter(router, proto_db);
 
         proto_db.SerializeToOstream(&output);
     }
 
-    std::tuple<map_renderer::RenderSettings, transport_router::TransportRouter, graph::DirectedWeightedGraph<double>> Deserialize(transport_catalogue::data_base::TransportCatalogue& db, std::istream& input)
+    std::tuple<map_renderer::RenderSettings, transport_router::TransportRouter, graph::DirectedWeightedGraph<double>, transport_router::RouterData> Deserialize(transport_catalogue::data_base::TransportCatalogue& db, std::istream& input)
     {        
         proto_transport_db::TransportCatalogue proto_db;
         proto_db.ParseFromIstream(&input);       
         
         DeserializeStops(db, proto_db);
+        db.SetStopGrid(DeserializeStopGrid(proto_db.stop_grid()));
         DeserializeDistances(db, proto_db);
         DeserializeBuses(db, proto_db); 
 
         map_renderer::RenderSettings settings = DeserializeRenderSettings(proto_db);        
         transport_router::TransportRouter router = DeserializeTransportRouter(db, proto_db.router());
         graph::DirectedWeightedGraph<double> graph = DeserializeGraph(proto_db.router().graph());
+        transport_router::RouterData router_data = DeserializeRouterData(proto_db.router());
 
-        return {std::move(settings), std::move(router), std::move(graph)};       
+        return {std::move(settings), std::move(router), std::move(graph), std::move(router_data)};       
     }
 //---------------------- Supporting Serialize Methods --------------------
     void SerializeStops(const transport_catalogue::data_base::TransportCatalogue &db, proto_transport_db::TransportCatalogue &proto_db)
     {
-        const auto all_stops = db.GetStops();        
-        for(const auto& stop : all_stops) {
-            proto_transport_db::Stop proto_stop;
-            proto_stop.set_name(stop.name);
-            proto_stop.set_latitude(stop.latitude);
-            proto_stop.set_longitude(stop.longitude);
-
-            *proto_db.add_stops() = std::move(proto_stop);            
+        proto_transport_db::Stops& proto_stops = *proto_db.mutable_stops();
+        const size_t stop_count = db.GetStopCount();
+        proto_stops.mutable_names()->Reserve(stop_count);
+        for(uint32_t stop_id = 0; stop_id < stop_count; ++stop_id) {
+            proto_stops.add_names(std::string(db.GetStopName(stop_id)));
         }
+        proto_stops.mutable_latitudes()->Add(db.GetStopLatitudes().begin(), db.GetStopLatitudes().end());
+        proto_stops.mutable_longitudes()->Add(db.GetStopLongitudes().begin(), db.GetStopLongitudes().end());
     }
 
     void SerializeBuses(const transport_catalogue::data_base::TransportCatalogue &db, proto_transport_db::TransportCatalogue &proto_db)
     {
-        const auto all_buses = db.GetBuses();
+        const auto& all_buses = db.GetBuses();
         for(const auto& bus : all_buses) {
             proto_transport_db::Bus proto_bus;
             proto_bus.set_name(bus.name);
-            for(const auto& stop : bus.stops) {
-                proto_bus.add_stops(stop->name);
-            }
+            proto_bus.mutable_stops()->Add(bus.stops.begin(), bus.stops.end());
             proto_bus.set_is_circle(transport_catalogue::data_base::RouteType::CIRCLE == bus.type);
             if(bus.second_final_stop.has_value()) {
-                proto_bus.set_second_final_stop(bus.second_final_stop.value()->name);
+                proto_bus.set_second_final_stop(bus.second_final_stop.value());
             }
+            proto_transport_db::BusStats& proto_stats = *proto_bus.mutable_stats();
+            proto_stats.set_stops_count(bus.stats.stops_count);
+            proto_stats.set_unique_stops_count(bus.stats.unique_stops_count);
+            proto_stats.set_route_length(bus.stats.route_length);
+            proto_stats.set_way(bus.stats.way);
+            proto_bus.mutable_road_distances()->Add(bus.road_distances.begin(), bus.road_distances.end());
+            proto_bus.mutable_geo_distances()->Add(bus.geo_distances.begin(), bus.geo_distances.end());
 
             *proto_db.add_buses() = std::move(proto_bus);
         }        
@@ -66,15 +73,27 @@ namespace Serialization {
 
     void SerializeDistances(const transport_catalogue::data_base::TransportCatalogue &db, proto_transport_db::TransportCatalogue &proto_db)
     {
-        const auto all_distances = db.GetAllWays();
-        for(const auto& [stops, distance] : all_distances) {
-            proto_transport_db::Distances proto_distance;
-            proto_distance.set_from(stops.first->name);
-            proto_distance.set_to(stops.second->name);
+        db.GetAllWays().ForEach([&proto_db](uint32_t from_stop, uint32_t to_stop, int distance) {
+            proto_transport_db::Distances& proto_distance = *proto_db.add_distance();
+            proto_distance.set_from(from_stop);
+            proto_distance.set_to(to_stop);
             proto_distance.set_distance(distance);
+        });
+    }
 
-            *proto_db.add_distance() = std::move(proto_distance);
-        }
+    proto_transport_db::StopGrid SerializeStopGrid(const transport_catalogue::data_base::StopGrid& stop_grid)
+    {
+        const auto& data = stop_grid.GetData();
+        proto_transport_db::StopGrid proto_stop_grid;
+        proto_stop_grid.set_min_latitude(data.min_latitude);
+        proto_stop_grid.set_min_longitude(data.min_longitude);
+        proto_stop_grid.set_cell_height(data.cell_height);
+        proto_stop_grid.set_cell_width(data.cell_width);
+        proto_stop_grid.set_rows(data.rows);
+        proto_stop_grid.set_columns(data.columns);
+        proto_stop_grid.mutable_cell_offsets()->Add(data.cell_offsets.begin(), data.cell_offsets.end());
+        proto_stop_grid.mutable_stop_ids()->Add(data.stop_ids.begin(), data.stop_ids.end());
+        return proto_stop_grid;
     }
 
     void SerializeRenderSettings(const map_renderer::RenderSettings& render_settings, proto_transport_db::TransportCatalogue &proto_db)
@@ -138,52 +157,82 @@ namespace Serialization {
         return std::move(proto_rgba);
     }
 
-    proto_transport_db::EdgeInfo SerializeEdgeInfo(const transport_router::EdgeInfo &edge_info)
+    proto_transport_db::EdgeInfos SerializeEdgeInfos(const std::vector<transport_router::EdgeInfo> &edge_infos)
     {
-        using namespace std::string_literals;
-        proto_transport_db::EdgeInfo proto_edge_info;
-        const auto edge_type = edge_info.type;        
-
-        switch (edge_type)
-        {
-        case transport_router::EdgeType::WAIT:
-            proto_edge_info.set_name(edge_info.stop_name);
-            proto_edge_info.set_type("Wait"s);
-            break;  
-        case transport_router::EdgeType::BUS:
-            proto_edge_info.set_name(edge_info.bus);
-            proto_edge_info.set_type("Bus"s);
-            break;      
-        default:
-            break;
+        proto_transport_db::EdgeInfos proto_edge_infos;
+        const int edge_count = static_cast<int>(edge_infos.size());
+        proto_edge_infos.mutable_is_bus()->Reserve(edge_count);
+        proto_edge_infos.mutable_name_id()->Reserve(edge_count);
+        proto_edge_infos.mutable_span_count()->Reserve(edge_count);
+        proto_edge_infos.mutable_distance()->Reserve(edge_count);
+        for(const auto& edge_info : edge_infos) {
+            proto_edge_infos.add_is_bus(edge_info.type == transport_router::EdgeType::BUS);
+            proto_edge_infos.add_name_id(edge_info.name_id);
+            proto_edge_infos.add_span_count(edge_info.span_count);
+            proto_edge_infos.add_distance(edge_info.distance);
         }
-
-        proto_edge_info.set_span_count(edge_info.span_count);
-        return std::move(proto_edge_info);
+        return proto_edge_infos;
     }
 
     proto_graph::Graph SerializeGraph(const graph::DirectedWeightedGraph<double> &graph)
     {
         proto_graph::Graph proto_graph;
 
-        for(size_t i = 0; i < graph.GetEdgeCount(); ++i) {
-            const auto edge = graph.GetEdge(i);
-            proto_graph::Edge proto_edge;
-            proto_edge.set_from(edge.from);
-            proto_edge.set_to(edge.to);
-            proto_edge.set_weight(edge.weight);
-            *proto_graph.add_edge() = proto_edge;
+        const size_t edge_count = graph.GetEdgeCount();
+        proto_graph.mutable_edge_from()->Reserve(edge_count);
+        proto_graph.mutable_edge_to()->Reserve(edge_count);
+        proto_graph.mutable_edge_weight()->Reserve(edge_count);
+        for(size_t i = 0; i < edge_count; ++i) {
+            const auto& edge = graph.GetEdge(i);
+            proto_graph.add_edge_from(edge.from);
+            proto_graph.add_edge_to(edge.to);
+            proto_graph.add_edge_weight(edge.weight);
         }
 
-        for(size_t i = 0; i < graph.GetVertexCount(); ++i) {
-            proto_graph::IncidenceList proto_list;
-            for(const auto& edge_id : graph.GetIncidentEdges(i)) {
-                proto_list.add_edge_id(edge_id);
+        const auto& offsets = graph.GetOffsets();
+        const auto& edge_ids = graph.GetOutgoingEdgeIds();
+        proto_graph.mutable_offset()->Add(offsets.begin(), offsets.end());
+        proto_graph.mutable_edge_id()->Add(edge_ids.begin(), edge_ids.end());
+
+        return proto_graph;
+    }
+
+    proto_graph::RoutesInternalData SerializeRoutesInternalData(const transport_router::AllPairsRouter::RoutesInternalData &routes_internal_data)
+    {
+        proto_graph::RoutesInternalData proto_routes_internal_data;
+        const size_t vertex_count = routes_internal_data.GetVertexCount();
+        proto_routes_internal_data.set_vertex_count(vertex_count);
+        proto_routes_internal_data.mutable_weight()->Reserve(vertex_count * vertex_count);
+        proto_routes_internal_data.mutable_prev_edge()->Reserve(vertex_count * vertex_count);
+
+        for(size_t from = 0; from < vertex_count; ++from) {
+            for(size_t to = 0; to < vertex_count; ++to) {
+                if(!routes_internal_data.HasRoute(from, to)) {
+                    proto_routes_internal_data.add_weight(0.);
+                    proto_routes_internal_data.add_prev_edge(-2);
+                    continue;
+                }
+                const auto prev_edge = routes_internal_data.GetPrevEdge(from, to);
+                proto_routes_internal_data.add_weight(routes_internal_data.GetWeight(from, to));
+                proto_routes_internal_data.add_prev_edge(prev_edge ? static_cast<int64_t>(*prev_edge) : -1);
             }
-            *proto_graph.add_incidence_list() = proto_list;
         }
 
-        return std::move(proto_graph);
+        return proto_routes_internal_data;
+    }
+
+    proto_graph::ContractionHierarchy SerializeContractionHierarchy(const transport_router::ContractionHierarchy::Hierarchy &hierarchy)
+    {
+        proto_graph::ContractionHierarchy proto_hierarchy;
+        proto_hierarchy.mutable_rank()->Add(hierarchy.ranks.begin(), hierarchy.ranks.end());
+        for(const auto& shortcut : hierarchy.shortcuts) {
+            proto_hierarchy.add_shortcut_from(shortcut.from);
+            proto_hierarchy.add_shortcut_to(shortcut.to);
+            proto_hierarchy.add_shortcut_weight(shortcut.weight);
+            proto_hierarchy.add_shortcut_first(shortcut.first);
+            proto_hierarchy.add_shortcut_second(shortcut.second);
+        }
+        return proto_hierarchy;
     }
 
     void SerializeTransportRouter(const transport_router::TransportRouter &router, proto_transport_db::TransportCatalogue &proto_db)
@@ -192,52 +241,79 @@ namespace Serialization {
         proto_router.set_bus_wait_time(router.GetBusWaitTime());
         proto_router.set_bus_velocity(router.GetBusVelocity());
         *proto_router.mutable_graph() = SerializeGraph(router.GetGraph());
-
-        for(const auto& [stop_name, stop_id] : router.GetStopnameToStopIdMap()) {
-            proto_transport_db::StopNameToId proto_stop;
-            proto_stop.set_stop_name(stop_name);
-            proto_stop.set_stop_id(stop_id);
-            *proto_router.add_stopname_to_id() = proto_stop;
+        proto_router.set_routing_mode(transport_router::RoutingModeToString(router.GetRoutingMode()));
+        proto_router.set_route_cache_capacity(router.GetRouteCacheCapacity());
+        proto_router.set_walking_velocity(router.GetWalkingVelocity());
+        proto_router.set_walking_stop_count(router.GetWalkingStopCount());
+        switch (router.GetRoutingMode())
+        {
+        case transport_router::RoutingMode::ALL_PAIRS:
+            *proto_router.mutable_routes_internal_data() = SerializeRoutesInternalData(router.GetRoutesInternalData());
+            break;
+        case transport_router::RoutingMode::CONTRACTION_HIERARCHIES:
+            *proto_router.mutable_contraction_hierarchy() = SerializeContractionHierarchy(router.GetContractionHierarchy());
+            break;
+        default:
+            break;
         }
 
-        for(const auto& [edge_id, edge_info] : router.GetEdgeIdToInfoMap()) {
-            proto_transport_db::EdgeIdToInfo proto_edge_id_to_info;
-            proto_edge_id_to_info.set_edge_id(edge_id);
-            *proto_edge_id_to_info.mutable_edge_info() = SerializeEdgeInfo(edge_info);
-            *proto_router.add_edge_id_to_info() = std::move(proto_edge_id_to_info);
-        }
+        *proto_router.mutable_edge_infos() = SerializeEdgeInfos(router.GetEdgeInfos());
 
         *proto_db.mutable_router() = std::move(proto_router);
     }
 //------------------ Supporting Deserialize Methods ------------------------------
     void DeserializeStops(transport_catalogue::data_base::TransportCatalogue &db, const proto_transport_db::TransportCatalogue &proto_db)
     {
-        for(size_t i = 0; i < proto_db.stops_size(); ++i) {
-            const auto proto_stop = proto_db.stops(i);
-            db.AddStop(proto_stop.name(), proto_stop.latitude(), proto_stop.longitude());            
+        const proto_transport_db::Stops& proto_stops = proto_db.stops();
+        if(proto_stops.latitudes_size() != proto_stops.names_size() || proto_stops.longitudes_size() != proto_stops.names_size()) {
+            throw std::invalid_argument("Stops are damaged");
+        }
+        for(int i = 0; i < proto_stops.names_size(); ++i) {
+            db.AddStop(proto_stops.names(i), proto_stops.latitudes(i), proto_stops.longitudes(i));
         }
     }
 
     void DeserializeBuses(transport_catalogue::data_base::TransportCatalogue &db, const proto_transport_db::TransportCatalogue &proto_db)
     {
-        for(size_t i = 0; i < proto_db.buses_size(); ++i) {
-            const auto proto_bus = proto_db.buses(i);
-            std::vector<std::string> stops;
-            stops.reserve(proto_bus.stops_size());
-            for(size_t j = 0; j < proto_bus.stops_size(); ++j) {
-                stops.push_back(proto_bus.stops(j));
+        for(const auto& proto_bus : proto_db.buses()) {
+            transport_catalogue::data_base::Bus bus;
+            bus.name = proto_bus.name();
+            bus.stops.assign(proto_bus.stops().begin(), proto_bus.stops().end());
+            bus.type = proto_bus.is_circle() ? transport_catalogue::data_base::RouteType::CIRCLE : transport_catalogue::data_base::RouteType::TWO_DIRECTIONAL;
+            if(proto_bus.has_second_final_stop()) {
+                bus.second_final_stop = proto_bus.second_final_stop();
             }
-            db.AddBus(proto_bus.name(), stops, proto_bus.is_circle(), proto_bus.second_final_stop());
+            bus.road_distances.assign(proto_bus.road_distances().begin(), proto_bus.road_distances().end());
+            bus.geo_distances.assign(proto_bus.geo_distances().begin(), proto_bus.geo_distances().end());
+            bus.stats.stops_count = proto_bus.stats().stops_count();
+            bus.stats.unique_stops_count = proto_bus.stats().unique_stops_count();
+            bus.stats.route_length = proto_bus.stats().route_length();
+            bus.stats.way = proto_bus.stats().way();
+            db.AddBus(std::move(bus));
         }
+        db.BuildStopBuses();
     }
 
     void DeserializeDistances(transport_catalogue::data_base::TransportCatalogue &db, const proto_transport_db::TransportCatalogue &proto_db)
     {
-        for(size_t i = 0; i < proto_db.distance_size(); ++i) {
-            const auto proto_distance = proto_db.distance(i);
+        for(const auto& proto_distance : proto_db.distance()) {
             db.AddWay(proto_distance.from(), proto_distance.to(), proto_distance.distance());
         }
     }
+    transport_catalogue::data_base::StopGrid::Data DeserializeStopGrid(const proto_transport_db::StopGrid& proto_stop_grid)
+    {
+        transport_catalogue::data_base::StopGrid::Data data;
+        data.min_latitude = proto_stop_grid.min_latitude();
+        data.min_longitude = proto_stop_grid.min_longitude();
+        data.cell_height = proto_stop_grid.cell_height();
+        data.cell_width = proto_stop_grid.cell_width();
+        data.rows = proto_stop_grid.rows();
+        data.columns = proto_stop_grid.columns();
+        data.cell_offsets.assign(proto_stop_grid.cell_offsets().begin(), proto_stop_grid.cell_offsets().end());
+        data.stop_ids.assign(proto_stop_grid.stop_ids().begin(), proto_stop_grid.stop_ids().end());
+        return data;
+    }
+
     map_renderer::RenderSettings DeserializeRenderSettings(const proto_transport_db::TransportCatalogue &proto_db)
     {
         proto_map::RenderSettings proto_settings = proto_db.render_settings();
@@ -283,71 +359,90 @@ namespace Serialization {
 
         return std::move(color);
     }
-    transport_router::EdgeInfo DeserializeEdgeInfo(const proto_transport_db::EdgeInfo &proto_info)
+    std::vector<transport_router::EdgeInfo> DeserializeEdgeInfos(const proto_transport_db::EdgeInfos &proto_edge_infos)
     {
-        using namespace std::string_literals;
-        transport_router::EdgeInfo edge_info;
-        std::string type = proto_info.type();
-        if ("Wait"s == type) {
-            edge_info.type = transport_router::EdgeType::WAIT;
-            edge_info.stop_name = proto_info.name();
-        } else if ("Bus"s == type) {
-            edge_info.type = transport_router::EdgeType::BUS;
-            edge_info.bus = proto_info.name();
+        const int edge_count = proto_edge_infos.is_bus_size();
+        if(proto_edge_infos.name_id_size() != edge_count || proto_edge_infos.span_count_size() != edge_count
+            || proto_edge_infos.distance_size() != edge_count) {
+            throw std::invalid_argument("Edge infos are damaged");
         }
-
-        edge_info.span_count = proto_info.span_count();
-        return std::move(edge_info);
+        std::vector<transport_router::EdgeInfo> edge_infos(static_cast<size_t>(edge_count));
+        for(int i = 0; i < edge_count; ++i) {
+            transport_router::EdgeInfo& edge_info = edge_infos[i];
+            edge_info.type = proto_edge_infos.is_bus(i) ? transport_router::EdgeType::BUS : transport_router::EdgeType::WAIT;
+            edge_info.name_id = proto_edge_infos.name_id(i);
+            edge_info.span_count = proto_edge_infos.span_count(i);
+            edge_info.distance = proto_edge_infos.distance(i);
+        }
+        return edge_infos;
     }
-    graph::Edge<double> DeserializeEdge(const proto_graph::Edge &proto_edge)
+    graph::DirectedWeightedGraph<double> DeserializeGraph(const proto_graph::Graph &proto_graph)
     {
-        graph::Edge<double> edge;
-        edge.from = proto_edge.from();
-        edge.to = proto_edge.to();
-        edge.weight = proto_edge.weight();
+        const int edge_count = proto_graph.edge_from_size();
+        if(proto_graph.edge_to_size() != edge_count || proto_graph.edge_weight_size() != edge_count) {
+            throw std::invalid_argument("Graph edges are damaged");
+        }
+        std::vector<graph::Edge<double>> edges;
+        edges.reserve(edge_count);
+        for(int i = 0; i < edge_count; ++i) {
+            edges.push_back({proto_graph.edge_from(i), proto_graph.edge_to(i), proto_graph.edge_weight(i)});
+        }
 
-        return std::move(edge);
+        std::vector<uint32_t> offsets(proto_graph.offset().begin(), proto_graph.offset().end());
+        std::vector<uint32_t> edge_ids(proto_graph.edge_id().begin(), proto_graph.edge_id().end());
+        return graph::DirectedWeightedGraph<double>(std::move(edges), std::move(offsets), std::move(edge_ids));
     }
-    std::vector<graph::EdgeId> DeserializeIncidenceList(const proto_graph::IncidenceList &proto_incidence_list)
+    transport_router::AllPairsRouter::RoutesInternalData DeserializeRoutesInternalData(const proto_graph::RoutesInternalData &proto_routes_internal_data)
     {
-        std::vector<graph::EdgeId> list;
-        list.reserve(proto_incidence_list.edge_id_size());
-        for(size_t i = 0; i < proto_incidence_list.edge_id_size(); ++i) {
-            list.push_back(proto_incidence_list.edge_id(i));
+        const size_t vertex_count = proto_routes_internal_data.vertex_count();
+        const int64_t cell_count = static_cast<int64_t>(vertex_count) * static_cast<int64_t>(vertex_count);
+        if(proto_routes_internal_data.prev_edge_size() != cell_count || proto_routes_internal_data.weight_size() != cell_count) {
+            throw std::invalid_argument("Routes internal data is damaged");
         }
-        return std::move(list);
-    }
-    graph::DirectedWeightedGraph<double> DeserializeGraph(proto_graph::Graph proto_graph)
-    {
-        std::vector<graph::Edge<double>> edges;
-        edges.reserve(proto_graph.edge_size());
-        for(size_t i = 0; i < proto_graph.edge_size(); ++i) {           
-            edges.emplace_back(DeserializeEdge(proto_graph.edge(i)));
-        }  
-
-        std::vector<std::vector<graph::EdgeId>> incidence_lists;
-        incidence_lists.reserve(proto_graph.incidence_list_size());
-        for(size_t i = 0; i < proto_graph.incidence_list_size(); ++i) {
-            incidence_lists.emplace_back(DeserializeIncidenceList(proto_graph.incidence_list(i)));
+        transport_router::AllPairsRouter::RoutesInternalData routes_internal_data(vertex_count);
+
+        for(size_t from = 0; from < vertex_count; ++from) {
+            for(size_t to = 0; to < vertex_count; ++to) {
+                const size_t cell = from * vertex_count + to;
+                const int64_t prev_edge = proto_routes_internal_data.prev_edge(cell);
+                if(prev_edge == -2) {
+                    continue;
+                }
+                if(prev_edge < -2) {
+                    throw std::invalid_argument("Routes internal data is damaged");
+                }
+                routes_internal_data.SetRoute(from, to, proto_routes_internal_data.weight(cell)
+                    , prev_edge == -1 ? std::nullopt : std::optional<graph::EdgeId>(prev_edge));
+            }
         }
-
-        return graph::DirectedWeightedGraph<double>(edges, incidence_lists);
+        return routes_internal_data;
     }
-    std::map<std::string, graph::VertexId> DeserializeStopnameToStopIdMap(const proto_transport_db::Router &proto_router)
+    transport_router::ContractionHierarchy::Hierarchy DeserializeContractionHierarchy(const proto_graph::ContractionHierarchy &proto_hierarchy)
     {
-        std::map<std::string, graph::VertexId> stopname_to_stop_id;
-        for(const auto& proto_stopname_id : proto_router.stopname_to_id()) {
-            stopname_to_stop_id[proto_stopname_id.stop_name()] = proto_stopname_id.stop_id();
+        const int shortcut_count = proto_hierarchy.shortcut_from_size();
+        if(proto_hierarchy.shortcut_to_size() != shortcut_count || proto_hierarchy.shortcut_weight_size() != shortcut_count
+            || proto_hierarchy.shortcut_first_size() != shortcut_count || proto_hierarchy.shortcut_second_size() != shortcut_count) {
+            throw std::invalid_argument("Contraction hierarchy is damaged");
+        }
+        transport_router::ContractionHierarchy::Hierarchy hierarchy;
+        hierarchy.ranks.assign(proto_hierarchy.rank().begin(), proto_hierarchy.rank().end());
+        hierarchy.shortcuts.reserve(shortcut_count);
+        for(int i = 0; i < shortcut_count; ++i) {
+            hierarchy.shortcuts.push_back({proto_hierarchy.shortcut_from(i), proto_hierarchy.shortcut_to(i)
+                , proto_hierarchy.shortcut_weight(i), proto_hierarchy.shortcut_first(i), proto_hierarchy.shortcut_second(i)});
         }
-        return std::move(stopname_to_stop_id);
+        return hierarchy;
     }
-    std::map<graph::EdgeId, transport_router::EdgeInfo> DeserializeEdgeIdToInfoMap(const proto_transport_db::Router &proto_router)
+    transport_router::RouterData DeserializeRouterData(const proto_transport_db::Router &proto_router)
     {
-        std::map<graph::EdgeId, transport_router::EdgeInfo> edge_id_to_info;
-        for(const auto& proto_edge_id_info : proto_router.edge_id_to_info()) {
-            edge_id_to_info[proto_edge_id_info.edge_id()] = DeserializeEdgeInfo(proto_edge_id_info.edge_info());
+        transport_router::RouterData router_data;
+        if(proto_router.has_routes_internal_data()) {
+            router_data.routes_internal_data = DeserializeRoutesInternalData(proto_router.routes_internal_data());
         }
-        return std::move(edge_id_to_info);
+        if(proto_router.has_contraction_hierarchy()) {
+            router_data.hierarchy = DeserializeContractionHierarchy(proto_router.contraction_hierarchy());
+        }
+        return router_data;
     }
     transport_router::TransportRouter DeserializeTransportRouter(transport_catalogue::data_base::TransportCatalogue &db, const proto_transport_db::Router &proto_router)
     {
@@ -355,8 +450,19 @@ namespace Serialization {
         
         router.SetBusWaitTime(proto_router.bus_wait_time());
         router.SetBusVelocity(proto_router.bus_velocity());
-        router.SetStopnameToStopIdMap(DeserializeStopnameToStopIdMap(proto_router));
-        router.SetEdgeIdToInfoMap(DeserializeEdgeIdToInfoMap(proto_router));
+        if(!proto_router.routing_mode().empty()) {
+            router.SetRoutingMode(transport_router::ParseRoutingMode(proto_router.routing_mode()));
+        }
+        if(proto_router.has_route_cache_capacity()) {
+            router.SetRouteCacheCapacity(proto_router.route_cache_capacity());
+        }
+        if(proto_router.has_walking_velocity()) {
+            router.SetWalkingVelocity(proto_router.walking_velocity());
+        }
+        if(proto_router.has_walking_stop_count()) {
+            router.SetWalkingStopCount(proto_router.walking_stop_count());
+        }
+        router.SetEdgeInfos(DeserializeEdgeInfos(proto_router.edge_infos()));
         
         return std::move(router);
     }
@@ -7,32 +7,35 @@
 
 namespace Serialization {
     void Serialize(transport_catalogue::data_base::TransportCatalogue& db, const map_renderer::RenderSettings& render_settings, const transport_router::TransportRouter &router, std::ostream& output);
-    std::tuple<map_renderer::RenderSettings, transport_router::TransportRouter, graph::DirectedWeightedGraph<double>> Deserialize(transport_catalogue::data_base::TransportCatalogue& db, std::istream& input);
+    std::tuple<map_renderer::RenderSettings, transport_router::TransportRouter, graph::DirectedWeightedGraph<double>, transport_router::RouterData> Deserialize(transport_catalogue::data_base::TransportCatalogue& db, std::istream& input);
 
     void SerializeStops(const transport_catalogue::data_base::TransportCatalogue& db, proto_transport_db::TransportCatalogue& proto_db);
     void SerializeBuses(const transport_catalogue::data_base::TransportCatalogue& db, proto_transport_db::TransportCatalogue& proto_db);
     void SerializeDistances(const transport_catalogue::data_base::TransportCatalogue& db, proto_transport_db::TransportCatalogue& proto_db);
+    proto_transport_db::StopGrid SerializeStopGrid(const transport_catalogue::data_base::StopGrid& stop_grid);
     void SerializeRenderSettings(const map_renderer::RenderSettings& render_settings, proto_transport_db::TransportCatalogue& proto_db);
     proto_map::Point SerializePoint(const svg::Point& point);
     proto_map::Color SerializeColor(const svg::Color& color);
     proto_map::Rgb SerializeRgb(const svg::Rgb& rgb);
     proto_map::Rgba SerializeRgba(const svg::Rgba& rgba);  
-    proto_transport_db::EdgeInfo SerializeEdgeInfo(const transport_router::EdgeInfo& edge_info);
+    proto_transport_db::EdgeInfos SerializeEdgeInfos(const std::vector<transport_router::EdgeInfo>& edge_infos);
     proto_graph::Graph SerializeGraph(const graph::DirectedWeightedGraph<double>& graph); 
+    proto_graph::RoutesInternalData SerializeRoutesInternalData(const transport_router::AllPairsRouter::RoutesInternalData& routes_internal_data);
+    proto_graph::ContractionHierarchy SerializeContractionHierarchy(const transport_router::ContractionHierarchy::Hierarchy& hierarchy);
     void SerializeTransportRouter(const transport_router::TransportRouter& router, proto_transport_db::TransportCatalogue &proto_db);
 
     void DeserializeStops(transport_catalogue::data_base::TransportCatalogue& db, const proto_transport_db::TransportCatalogue& proto_db);
     void DeserializeBuses(transport_catalogue::data_base::TransportCatalogue& db, const proto_transport_db::TransportCatalogue& proto_db);
     void DeserializeDistances(transport_catalogue::data_base::TransportCatalogue& db, const proto_transport_db::TransportCatalogue& proto_db);
+    transport_catalogue::data_base::StopGrid::Data DeserializeStopGrid(const proto_transport_db::StopGrid& proto_stop_grid);
     map_renderer::RenderSettings DeserializeRenderSettings(const proto_transport_db::TransportCatalogue& proto_db);
     svg::Point DeserializePoint(const proto_map::Point& proto_point);
     svg::Color DeserializeColor(const proto_map::Color& proto_color);
-    transport_router::EdgeInfo DeserializeEdgeInfo(const proto_transport_db::EdgeInfo& proto_info);
-    graph::Edge<double> DeserializeEdge(const proto_graph::Edge& proto_edge);
-    std::vector<graph::EdgeId> DeserializeIncidenceList(const proto_graph::IncidenceList& proto_incidence_list);
-    graph::DirectedWeightedGraph<double> DeserializeGraph(proto_graph::Graph proto_graph);
-    std::map<std::string, graph::VertexId> DeserializeStopnameToStopIdMap(const proto_transport_db::Router &proto_router);
-    std::map<graph::EdgeId, transport_router::EdgeInfo> DeserializeEdgeIdToInfoMap(const proto_transport_db::Router &proto_router);
+    std::vector<transport_router::EdgeInfo> DeserializeEdgeInfos(const proto_transport_db::EdgeInfos& proto_edge_infos);
+    graph::DirectedWeightedGraph<double> DeserializeGraph(const proto_graph::Graph& proto_graph);
+    transport_router::AllPairsRouter::RoutesInternalData DeserializeRoutesInternalData(const proto_graph::RoutesInternalData& proto_routes_internal_data);
+    transport_router::ContractionHierarchy::Hierarchy DeserializeContractionHierarchy(const proto_graph::ContractionHierarchy& proto_hierarchy);
+    transport_router::RouterData DeserializeRouterData(const proto_transport_db::Router &proto_router);
     transport_router::TransportRouter DeserializeTransportRouter(transport_catalogue::data_base::TransportCatalogue& db, const proto_transport_db::Router &proto_router);
     
      
@@ -0,0 +1,184 @@
+#define _USE_MATH_DEFINES
+#include "stop_grid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace transport_catalogue {
+	namespace data_base {
+		namespace {
+			constexpr double DEGREES_TO_RADIANS = M_PI / 180.;
+			// Keeps cells of a base near a pole from getting infinitely wide
+			constexpr double MIN_LATITUDE_COS = 0.01;
+			constexpr double MIN_CELL_SIZE = 1e-6;
+
+			// Index of the cell holding the coordinate, clamped to [low, high]
+			int64_t GetCellIndex(double coordinate, double min_coordinate, double cell_size, int64_t low, int64_t high)
+			{
+				const double index = std::floor((coordinate - min_coordinate) / cell_size);
+				if (!(index >= low)) {
+					return low;
+				}
+				return index > high ? high : static_cast<int64_t>(index);
+			}
+		}
+
+		StopGrid::StopGrid(const std::vector<double>& latitudes, const std::vector<double>& longitudes)
+		{
+			const size_t stop_count = latitudes.size();
+			data_.cell_offsets.assign(1, 0);
+			if (stop_count == 0) {
+				return;
+			}
+
+			const auto [min_latitude, max_latitude] = std::minmax_element(latitudes.begin(), latitudes.end());
+			const auto [min_longitude, max_longitude] = std::minmax_element(longitudes.begin(), longitudes.end());
+			data_.min_latitude = *min_latitude;
+			data_.min_longitude = *min_longitude;
+
+			// Cells are square on the ground, sized so that there are about as many cells as stops.
+			// A long and narrow box gets at least one stop per cell along its long side
+			const double latitude_cos = std::max(MIN_LATITUDE_COS, std::cos((*min_latitude + *max_latitude) / 2 * DEGREES_TO_RADIANS));
+			const double height = *max_latitude - *min_latitude;
+			const double width = (*max_longitude - *min_longitude) * latitude_cos;
+			const double cell_size = std::max({ std::sqrt(height * width / stop_count), std::max(height, width) / stop_count, MIN_CELL_SIZE });
+			data_.cell_height = cell_size;
+			data_.cell_width = cell_size / latitude_cos;
+			data_.rows = static_cast<uint32_t>(height / data_.cell_height) + 1;
+			data_.columns = static_cast<uint32_t>((*max_longitude - *min_longitude) / data_.cell_width) + 1;
+
+			std::vector<uint32_t> stop_cells(stop_count);
+			for (size_t stop_id = 0; stop_id < stop_count; ++stop_id) {
+				const int64_t row = GetCellIndex(latitudes[stop_id], data_.min_latitude, data_.cell_height, 0, data_.rows - 1);
+				const int64_t column = GetCellIndex(longitudes[stop_id], data_.min_longitude, data_.cell_width, 0, data_.columns - 1);
+				stop_cells[stop_id] = static_cast<uint32_t>(row * data_.columns + column);
+			}
+
+			data_.cell_offsets.assign(static_cast<size_t>(data_.rows) * data_.columns + 1, 0);
+			for (const uint32_t cell : stop_cells) {
+				++data_.cell_offsets[cell + 1];
+			}
+			for (size_t cell = 0; cell + 1 < data_.cell_offsets.size(); ++cell) {
+				data_.cell_offsets[cell + 1] += data_.cell_offsets[cell];
+			}
+			data_.stop_ids.resize(stop_count);
+			std::vector<uint32_t> positions(data_.cell_offsets.begin(), data_.cell_offsets.end() - 1);
+			for (uint32_t stop_id = 0; stop_id < stop_count; ++stop_id) {
+				data_.stop_ids[positions[stop_cells[stop_id]]++] = stop_id;
+			}
+		}
+
+		StopGrid::StopGrid(Data data, size_t stop_count)
+			: data_(std::move(data))
+		{
+			const size_t cell_count = static_cast<size_t>(data_.rows) * data_.columns;
+			if (data_.cell_offsets.size() != cell_count + 1 || data_.cell_offsets.front() != 0
+				|| data_.cell_offsets.back() != data_.stop_ids.size() || data_.stop_ids.size() != stop_count
+				|| (cell_count > 0 && !(data_.cell_height > 0 && data_.cell_width > 0))) {
+				throw std::invalid_argument("Stop grid is damaged");
+			}
+			if (!std::is_sorted(data_.cell_offsets.begin(), data_.cell_offsets.end())
+				|| std::any_of(data_.stop_ids.begin(), data_.stop_ids.end(), [stop_count](uint32_t stop_id) { return stop_id >= stop_count; })) {
+				throw std::invalid_argument("Stop grid is damaged");
+			}
+		}
+
+		std::vector<StopGrid::NearStop> StopGrid::FindNearest(geo::Coordinates point, size_t max_count, double max_distance
+			, const geo::PointColumns& stops) const
+		{
+			std::vector<NearStop> nearest;
+			if (data_.stop_ids.empty() || max_count == 0) {
+				return nearest;
+			}
+
+			// A point outside the grid is moved into the ring of cells around it, which only weakens the bounds
+			const int64_t rows = data_.rows;
+			const int64_t columns = data_.columns;
+			const int64_t point_row = GetCellIndex(point.lat, data_.min_latitude, data_.cell_height, -1, rows);
+			const int64_t point_column = GetCellIndex(point.lng, data_.min_longitude, data_.cell_width, -1, columns);
+			const int64_t max_ring = std::max({ point_row, rows - 1 - point_row, point_column, columns - 1 - point_column });
+			const double max_abs_latitude = std::max({ std::abs(point.lat), std::abs(data_.min_latitude)
+				, std::abs(data_.min_latitude + rows * data_.cell_height) });
+
+			// Max-heap of the nearest stops found so far, the farthest of them on top
+			const auto is_nearer = [](const NearStop& lhs, const NearStop& rhs) {
+				return lhs.second < rhs.second || (lhs.second == rhs.second && lhs.first < rhs.first);
+			};
+			// Stops of the current ring and the distances to them, computed in one batch per ring
+			std::vector<uint32_t> ring_stops;
+			std::vector<double> distances;
+			const auto visit_cell = [&](int64_t row, int64_t column) {
+				const size_t cell = static_cast<size_t>(row * columns + column);
+				ring_stops.insert(ring_stops.end(), data_.stop_ids.begin() + data_.cell_offsets[cell]
+					, data_.stop_ids.begin() + data_.cell_offsets[cell + 1]);
+			};
+			const auto add_ring_stops = [&]() {
+				distances.resize(ring_stops.size());
+				geo::ComputeDistances(point, stops, ring_stops.data(), ring_stops.size(), distances.data());
+				for (size_t i = 0; i < ring_stops.size(); ++i) {
+					const NearStop stop{ ring_stops[i], distances[i] };
+					if (!(stop.second <= max_distance)) {
+						continue;
+					}
+					if (nearest.size() < max_count) {
+						nearest.push_back(stop);
+						std::push_heap(nearest.begin(), nearest.end(), is_nearer);
+					}
+					else if (is_nearer(stop, nearest.front())) {
+						std::pop_heap(nearest.begin(), nearest.end(), is_nearer);
+						nearest.back() = stop;
+						std::push_heap(nearest.begin(), nearest.end(), is_nearer);
+					}
+				}
+				ring_stops.clear();
+			};
+
+			for (int64_t ring = 0; ring <= max_ring; ++ring) {
+				// Stops of the ring are at least ring - 1 whole cells away from the point
+				if (ring >= 2) {
+					const double limit = nearest.size() == max_count ? std::min(max_distance, nearest.front().second) : max_distance;
+					if (ComputeRingDistance(ring - 1, max_abs_latitude) > limit) {
+						break;
+					}
+				}
+				for (int64_t row = std::max<int64_t>(0, point_row - ring); row <= std::min(rows - 1, point_row + ring); ++row) {
+					if (row == point_row - ring || row == point_row + ring) {
+						for (int64_t column = std::max<int64_t>(0, point_column - ring); column <= std::min(columns - 1, point_column + ring); ++column) {
+							visit_cell(row, column);
+						}
+						continue;
+					}
+					if (point_column - ring >= 0 && point_column - ring < columns) {
+						visit_cell(row, point_column - ring);
+					}
+					if (point_column + ring >= 0 && point_column + ring < columns) {
+						visit_cell(row, point_column + ring);
+					}
+				}
+				add_ring_stops();
+			}
+
+			std::sort_heap(nearest.begin(), nearest.end(), is_nearer);
+			return nearest;
+		}
+
+		const StopGrid::Data& StopGrid::GetData() const
+		{
+			return data_;
+		}
+
+		double StopGrid::ComputeRingDistance(int64_t cells, double max_abs_latitude) const
+		{
+			// No route between two latitudes is shorter than their difference. For longitudes the haversine
+			// formula gives sin^2(d / 2R) >= cos(lat1) * cos(lat2) * sin^2(dlng / 2), and both cosines
+			// are at least the cosine of the largest latitude
+			const double latitude_gap = cells * data_.cell_height * DEGREES_TO_RADIANS;
+			const double longitude_gap = std::min(M_PI, cells * data_.cell_width * DEGREES_TO_RADIANS);
+			const double latitude_cos = std::cos(std::min(90., max_abs_latitude) * DEGREES_TO_RADIANS);
+			const double latitude_distance = geo::EARTH_RADIUS * latitude_gap;
+			const double longitude_distance = 2 * geo::EARTH_RADIUS * std::asin(std::min(1., latitude_cos * std::sin(longitude_gap / 2)));
+			return std::min(latitude_distance, longitude_distance) - DISTANCE_ROUNDING;
+		}
+	}
+}
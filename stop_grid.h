@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "geo.h"
+
+namespace transport_catalogue {
+	namespace data_base {
+		// Uniform grid of cells over the bounding box of the stops, about one stop per cell.
+		// Nearest stops are searched ring by ring of cells around the point, and the search stops
+		// once no stop of the next ring can be closer than the ones already found
+		class StopGrid {
+		public:
+			// Cells are cell_height degrees of latitude by cell_width degrees of longitude, starting
+			// from the south-west corner. Stops of cell (row, column) are stop_ids[cell_offsets[i]] ...
+			// stop_ids[cell_offsets[i + 1] - 1], where i = row * columns + column
+			struct Data
+			{
+				double min_latitude = 0;
+				double min_longitude = 0;
+				double cell_height = 0;
+				double cell_width = 0;
+				uint32_t rows = 0;
+				uint32_t columns = 0;
+				std::vector<uint32_t> cell_offsets;
+				std::vector<uint32_t> stop_ids;
+			};
+
+			// Stop id and the distance to it in meters
+			using NearStop = std::pair<uint32_t, double>;
+
+			StopGrid(const std::vector<double>& latitudes, const std::vector<double>& longitudes);
+			// Throws std::invalid_argument if the data does not describe a grid of stop_count stops
+			StopGrid(Data data, size_t stop_count);
+
+			// At most max_count stops not farther than max_distance meters from the point, nearest first.
+			// Stops are the points of the columns, the distances to the stops of a cell are computed in one batch
+			std::vector<NearStop> FindNearest(geo::Coordinates point, size_t max_count, double max_distance
+				, const geo::PointColumns& stops) const;
+			const Data& GetData() const;
+
+		private:
+			// Meters the computed distance of two points may fall short of the exact one
+			static constexpr double DISTANCE_ROUNDING = 1;
+
+			// The least distance from the point to a stop `cells` whole cells away from the point's cell
+			// in latitude or longitude. max_abs_latitude bounds the latitudes of the point and the stops
+			double ComputeRingDistance(int64_t cells, double max_abs_latitude) const;
+
+			Data data_;
+		};
+	}
+}
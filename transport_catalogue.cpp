@@ -1,75 +1,256 @@
 #include "transport_catalogue.h"
 
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
 namespace transport_catalogue {
 	namespace data_base {
-		void TransportCatalogue::AddStop(const std::string& name, double latitude, double longitude)
+		void TransportCatalogue::AddStop(std::string_view name, double latitude, double longitude)
 		{
-			Stop stop = { name, latitude, longitude };
-			stops_.emplace_back(std::move(stop));
-			stopname_to_stop_[stops_.back().name] = &stops_.back();
-			stop_to_buses_[FindStop(stops_.back().name)];
+			const uint32_t stop_id = static_cast<uint32_t>(stop_names_.size());
+			stop_names_.push_back(stop_names_arena_.Store(name));
+			stop_latitudes_.push_back(latitude);
+			stop_longitudes_.push_back(longitude);
+			stop_latitude_sines_.push_back(geo::ComputeLatitudeSine(latitude));
+			stop_latitude_cosines_.push_back(geo::ComputeLatitudeCosine(latitude));
+			stopname_to_id_[stop_names_.back()] = stop_id;
+			stop_bus_offsets_.clear();
+			stop_grid_.reset();
 		}
 
-		Stop* TransportCatalogue::FindStop(std::string_view name) const
+		std::optional<uint32_t> TransportCatalogue::FindStop(std::string_view name) const
 		{
-			if (!stopname_to_stop_.count(name)) {
-				return nullptr;
-			}
+			const auto it = stopname_to_id_.find(name);
+			return it != stopname_to_id_.end() ? std::optional<uint32_t>(it->second) : std::nullopt;
+		}
 
-			return stopname_to_stop_.at(name);
+		void TransportCatalogue::SetStopCoordinates(uint32_t stop_id, double latitude, double longitude)
+		{
+			stop_latitudes_.at(stop_id) = latitude;
+			stop_longitudes_.at(stop_id) = longitude;
+			stop_latitude_sines_[stop_id] = geo::ComputeLatitudeSine(latitude);
+			stop_latitude_cosines_[stop_id] = geo::ComputeLatitudeCosine(latitude);
+			stop_grid_.reset();
 		}
 
-		void TransportCatalogue::AddWay(std::string_view from_stop, std::string_view to_stop, int distance)
+		size_t TransportCatalogue::GetStopCount() const
 		{
-			stop_to_stop_distance_[{FindStop(from_stop), FindStop(to_stop)}] = distance;
+			return stop_names_.size();
 		}
 
-		int TransportCatalogue::FindWay(std::pair<Stop*, Stop*> from_stop_to_stop) const
+		std::string_view TransportCatalogue::GetStopName(uint32_t stop_id) const
 		{
-			if (stop_to_stop_distance_.count(from_stop_to_stop)) {
-				return stop_to_stop_distance_.at(from_stop_to_stop);
-			}
-			std::pair<Stop*, Stop*> reversed_pair;
-			reversed_pair = std::make_pair(from_stop_to_stop.second, from_stop_to_stop.first);
-			if (stop_to_stop_distance_.count(reversed_pair)) {
-				return stop_to_stop_distance_.at(reversed_pair);
+			return stop_names_.at(stop_id);
+		}
+
+		geo::Coordinates TransportCatalogue::GetStopCoordinates(uint32_t stop_id) const
+		{
+			return { stop_latitudes_.at(stop_id), stop_longitudes_.at(stop_id) };
+		}
+
+		const std::vector<double>& TransportCatalogue::GetStopLatitudes() const
+		{
+			return stop_latitudes_;
+		}
+
+		const std::vector<double>& TransportCatalogue::GetStopLongitudes() const
+		{
+			return stop_longitudes_;
+		}
+
+		geo::PointColumns TransportCatalogue::GetStopPoints() const
+		{
+			return { stop_latitudes_.data(), stop_longitudes_.data(), stop_latitude_sines_.data(), stop_latitude_cosines_.data() };
+		}
+
+		void TransportCatalogue::AddWay(std::string_view from_stop, std::string_view to_stop, int distance)
+		{
+			const auto from_id = FindStop(from_stop);
+			const auto to_id = FindStop(to_stop);
+			if (from_id && to_id) {
+				AddWay(*from_id, *to_id, distance);
 			}
-			return 0;
 		}
 
-        const std::unordered_map<std::pair<Stop *, Stop *>, int, TransportCatalogue::PairPtrHasher<Stop, Stop>> &TransportCatalogue::GetAllWays() const
-        {
-            return stop_to_stop_distance_;
-        }
+		void TransportCatalogue::AddWay(uint32_t from_stop, uint32_t to_stop, int distance)
+		{
+			stop_to_stop_distance_.Set(from_stop, to_stop, distance);
+		}
+
+		int TransportCatalogue::FindWay(uint32_t from_stop, uint32_t to_stop) const
+		{
+			return stop_to_stop_distance_.Find(from_stop, to_stop);
+		}
+
+		const DistanceTable& TransportCatalogue::GetAllWays() const
+		{
+			return stop_to_stop_distance_;
+		}
 
-        void TransportCatalogue::AddBus(const std::string& bus, const std::vector<std::string>& stops, bool is_roundtrip, const std::string second_final_stop)
+		void TransportCatalogue::AddBus(const std::string& bus, const std::vector<std::string>& stops, bool is_roundtrip, const std::string second_final_stop)
 		{
-			std::vector<Stop*> stops_ptr;
-			stops_ptr.reserve(stops.size());
+			Bus new_bus;
+			new_bus.name = bus;
+			new_bus.stops.reserve(stops.size());
 			for (const auto& stop : stops) {
-				stops_ptr.push_back(FindStop(stop));
+				new_bus.stops.push_back(FindStop(stop).value());
 			}
-			RouteType type;
-			is_roundtrip ? type = RouteType::CIRCLE : type = RouteType::TWO_DIRECTIONAL;
-			Bus new_bus = { bus, std::move(stops_ptr), type };
+			new_bus.type = is_roundtrip ? RouteType::CIRCLE : RouteType::TWO_DIRECTIONAL;
 			if (!second_final_stop.empty()) {
-				new_bus.second_final_stop.emplace(FindStop(second_final_stop));
+				new_bus.second_final_stop = FindStop(second_final_stop).value();
 			}
-			buses_.emplace_back(std::move(new_bus));
-			busname_to_bus_[buses_.back().name] = &buses_.back();
-			const auto& current_bus = FindBus(buses_.back().name);
-			for (const auto& stop_ptr : current_bus->stops) {
-				stop_to_buses_[stop_ptr].insert(current_bus->name);
+			ComputeBusDistances(new_bus);
+			AddBus(std::move(new_bus));
+		}
+
+		void TransportCatalogue::AddBus(Bus bus)
+		{
+			for (const uint32_t stop_id : bus.stops) {
+				if (stop_id >= stop_names_.size()) {
+					throw std::out_of_range("Unknown stop id of bus "s + bus.name);
+				}
 			}
+			if (bus.road_distances.size() != bus.stops.size() || bus.geo_distances.size() != bus.stops.size()) {
+				throw std::invalid_argument("Distances do not match the stops of bus "s + bus.name);
+			}
+			buses_.push_back(std::move(bus));
+			busname_to_bus_[buses_.back().name] = &buses_.back();
+			stop_bus_offsets_.clear();
 		}
 
 		Bus* TransportCatalogue::FindBus(std::string_view name) const
 		{
-			if (!busname_to_bus_.count(name)) {
-				return nullptr;
+			const auto it = busname_to_bus_.find(name);
+			return it != busname_to_bus_.end() ? it->second : nullptr;
+		}
+
+		void TransportCatalogue::RemoveBus(std::string_view name)
+		{
+			const Bus* removed_bus = FindBus(name);
+			if (removed_bus == nullptr) {
+				return;
 			}
 
-			return busname_to_bus_.at(name);
+			// Erasing from the middle of a deque moves its elements anyway, so the indexes are rebuilt
+			std::deque<Bus> buses;
+			for (auto& bus : buses_) {
+				if (&bus != removed_bus) {
+					buses.push_back(std::move(bus));
+				}
+			}
+			buses_ = std::move(buses);
+			busname_to_bus_.clear();
+			for (auto& bus : buses_) {
+				busname_to_bus_[bus.name] = &bus;
+			}
+			stop_bus_offsets_.clear();
+		}
+
+		void TransportCatalogue::BuildStopBuses()
+		{
+			std::vector<uint32_t> bus_order(buses_.size());
+			std::iota(bus_order.begin(), bus_order.end(), 0);
+			std::sort(bus_order.begin(), bus_order.end(), [this](uint32_t lhs, uint32_t rhs) {
+				return buses_[lhs].name < buses_[rhs].name;
+			});
+
+			// Buses are walked in the order of names twice, first counting the buses of every stop and then
+			// placing them. A bus passing a stop again is met right after itself and is skipped
+			const size_t stop_count = stop_names_.size();
+			constexpr uint32_t NO_BUS = std::numeric_limits<uint32_t>::max();
+			std::vector<uint32_t> last_buses(stop_count, NO_BUS);
+			stop_bus_offsets_.assign(stop_count + 1, 0);
+			for (const uint32_t bus_id : bus_order) {
+				for (const uint32_t stop_id : buses_[bus_id].stops) {
+					if (last_buses[stop_id] != bus_id) {
+						last_buses[stop_id] = bus_id;
+						++stop_bus_offsets_[stop_id + 1];
+					}
+				}
+			}
+			for (size_t stop_id = 0; stop_id < stop_count; ++stop_id) {
+				stop_bus_offsets_[stop_id + 1] += stop_bus_offsets_[stop_id];
+			}
+
+			stop_buses_.resize(stop_bus_offsets_.back());
+			std::vector<uint32_t> positions(stop_bus_offsets_.begin(), stop_bus_offsets_.end() - 1);
+			last_buses.assign(stop_count, NO_BUS);
+			for (const uint32_t bus_id : bus_order) {
+				for (const uint32_t stop_id : buses_[bus_id].stops) {
+					if (last_buses[stop_id] != bus_id) {
+						last_buses[stop_id] = bus_id;
+						stop_buses_[positions[stop_id]++] = bus_id;
+					}
+				}
+			}
+		}
+
+		ranges::Range<const uint32_t*> TransportCatalogue::GetStopBuses(uint32_t stop_id) const
+		{
+			if (stop_bus_offsets_.empty()) {
+				throw std::logic_error("Buses of stops are not indexed");
+			}
+			const uint32_t* data = stop_buses_.data();
+			return { data + stop_bus_offsets_.at(stop_id), data + stop_bus_offsets_.at(stop_id + 1) };
+		}
+
+		void TransportCatalogue::UpdateBusStats()
+		{
+			for (Bus& bus : buses_) {
+				ComputeBusDistances(bus);
+			}
+		}
+
+		void TransportCatalogue::ComputeBusDistances(Bus& bus) const
+		{
+			bus.road_distances.assign(bus.stops.size(), 0);
+			bus.geo_distances.assign(bus.stops.size(), 0.);
+			// Every span is computed in one batch into the tail of the prefix sums, which are summed in place
+			if (bus.stops.size() > 1) {
+				geo::ComputeDistances(GetStopPoints(), bus.stops.data(), bus.stops.data() + 1, bus.stops.size() - 1, bus.geo_distances.data() + 1);
+			}
+			for (size_t i = 1; i < bus.stops.size(); ++i) {
+				bus.road_distances[i] = bus.road_distances[i - 1] + FindWay(bus.stops[i - 1], bus.stops[i]);
+				bus.geo_distances[i] += bus.geo_distances[i - 1];
+			}
+
+			std::vector<uint32_t> unique_stops = bus.stops;
+			std::sort(unique_stops.begin(), unique_stops.end());
+			bus.stats.stops_count = bus.stops.size();
+			bus.stats.unique_stops_count = std::unique(unique_stops.begin(), unique_stops.end()) - unique_stops.begin();
+			bus.stats.route_length = bus.stops.empty() ? 0. : bus.geo_distances.back();
+			bus.stats.way = bus.stops.empty() ? 0 : bus.road_distances.back();
+		}
+
+		void TransportCatalogue::BuildStopGrid()
+		{
+			stop_grid_.emplace(stop_latitudes_, stop_longitudes_);
+		}
+
+		void TransportCatalogue::SetStopGrid(StopGrid::Data data)
+		{
+			stop_grid_.emplace(std::move(data), stop_names_.size());
+		}
+
+		const StopGrid& TransportCatalogue::GetStopGrid() const
+		{
+			if (!stop_grid_) {
+				throw std::logic_error("Stops are not indexed by coordinates");
+			}
+			return *stop_grid_;
+		}
+
+		std::vector<NearbyStop> TransportCatalogue::FindNearestStops(geo::Coordinates point, size_t max_count, double max_distance) const
+		{
+			std::vector<NearbyStop> nearby_stops;
+			for (const auto& [stop_id, distance] : GetStopGrid().FindNearest(point, max_count, max_distance, GetStopPoints())) {
+				nearby_stops.push_back({ stop_names_[stop_id], distance });
+			}
+			return nearby_stops;
 		}
 
 		BusInfo TransportCatalogue::GetBusInfo(std::string_view name) const
@@ -84,54 +265,26 @@ namespace transport_catalogue {
 
 			bus_info.status = ReserchStatus::FOUND;
 			bus_info.bus_name = bus->name;
-			bus_info.stops_count = bus->stops.size();
-
-			std::unordered_set<std::string_view, StringViewHasher> unique_stops;
-
-			geo::Coordinates from;
-			geo::Coordinates to;
-			bus_info.route_length = 0.;
-			bool is_first = true;
-			std::pair<Stop*, Stop*> from_stop_to_stop;
-			for (const auto& stop : bus->stops) {
-				if (is_first) {
-					unique_stops.insert(stop->name);
-					from.lat = stop->latitude;
-					from.lng = stop->longitude;
-					from_stop_to_stop.first = FindStop(stop->name);
-					is_first = false;
-					continue;
-				}
-				unique_stops.insert(stop->name);
-				to.lat = stop->latitude;
-				to.lng = stop->longitude;
-
-				bus_info.route_length += ComputeDistance(from, to);
-				from = to;
-
-				from_stop_to_stop.second = FindStop(stop->name);
-				bus_info.way += FindWay(from_stop_to_stop);
-				from_stop_to_stop.first = from_stop_to_stop.second;
-			}
-
-			bus_info.unique_stops_count = unique_stops.size();
-
+			bus_info.stops_count = bus->stats.stops_count;
+			bus_info.unique_stops_count = bus->stats.unique_stops_count;
+			bus_info.route_length = bus->stats.route_length;
+			bus_info.way = bus->stats.way;
 			return bus_info;
 		}
 
 		StopInfo TransportCatalogue::GetStopInfo(std::string_view name) const
 		{
 			StopInfo stop_info;
-			if (FindStop(name) == nullptr) {
+			const auto stop_id = FindStop(name);
+			if (!stop_id) {
 				stop_info.status = ReserchStatus::NOT_FOUND;
 				stop_info.stop_name = name;
 				return stop_info;
 			}
 
-			const auto& stop = FindStop(name);
 			stop_info.status = ReserchStatus::FOUND;
-			stop_info.stop_name = stop->name;
-			stop_info.buses = stop_to_buses_.at(stop);
+			stop_info.stop_name = stop_names_[*stop_id];
+			stop_info.buses = GetStopBuses(*stop_id);
 			return stop_info;
 		}
 
@@ -140,14 +293,23 @@ namespace transport_catalogue {
 			return buses_;
 		}	
         
-        const std::deque<Stop>& TransportCatalogue::GetStops() const
-		{
-			return stops_;
-		}	
-
 		size_t TransportCatalogue::StringViewHasher::operator()(const std::string_view& str) const
 		{
 			return std::hash<std::string_view>{}(str);
 		}
+
+		std::string_view TransportCatalogue::NameArena::Store(std::string_view name)
+		{
+			if (blocks_.empty() || name.size() > block_size_ - block_used_) {
+				// A name longer than a block gets a block of its own
+				block_size_ = std::max(BLOCK_SIZE, name.size());
+				block_used_ = 0;
+				blocks_.push_back(std::make_unique<char[]>(block_size_));
+			}
+			char* data = blocks_.back().get() + block_used_;
+			std::copy(name.begin(), name.end(), data);
+			block_used_ += name.size();
+			return { data, name.size() };
+		}
 	}
 }
\ No newline at end of file
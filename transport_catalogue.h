@@ -1,15 +1,18 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
 #include <deque>
 #include <unordered_map>
-#include <unordered_set>
-#include <set>
 
+#include "distance_table.h"
 #include "domain.h"
 #include "geo.h"
+#include "stop_grid.h"
 
 namespace transport_catalogue {
 	namespace data_base {
@@ -21,36 +24,84 @@ namespace transport_catalogue {
 				size_t operator()(const std::string_view& str) const;
 			};
 
-			template<typename T, typename U>
-			struct PairPtrHasher
+			// Keeps strings in large blocks, so views of them stay valid while more are stored
+			class NameArena
 			{
-				size_t operator()(const std::pair<T*, U*>& p) const {
-					std::hash<T*> hasher_t;
-					std::hash<U*> hasher_u;
-					return hasher_t(p.first) * 51 + hasher_u(p.second) * (51 * 51);
-				}
+			public:
+				std::string_view Store(std::string_view name);
+
+			private:
+				static constexpr size_t BLOCK_SIZE = 1 << 16;
+
+				std::vector<std::unique_ptr<char[]>> blocks_;
+				size_t block_size_ = 0;
+				size_t block_used_ = 0;
 			};
 
-			std::deque<Stop> stops_;
-			std::unordered_map<std::string_view, Stop*, StringViewHasher> stopname_to_stop_;
+			// Stops are stored by columns, the id of a stop is its index in each of them.
+			// Ids are dense and never change
+			NameArena stop_names_arena_;
+			std::vector<std::string_view> stop_names_;
+			std::vector<double> stop_latitudes_;
+			std::vector<double> stop_longitudes_;
+			// Kept along with the latitudes for geo::PointColumns
+			std::vector<double> stop_latitude_sines_;
+			std::vector<double> stop_latitude_cosines_;
+			std::unordered_map<std::string_view, uint32_t, StringViewHasher> stopname_to_id_;
 			std::deque<Bus> buses_;
 			std::unordered_map<std::string_view, Bus*, StringViewHasher> busname_to_bus_;
-			std::unordered_map<Stop*, std::set<std::string_view>> stop_to_buses_;
-			std::unordered_map<std::pair<Stop*, Stop*>, int, PairPtrHasher<Stop, Stop>> stop_to_stop_distance_;
+			// Ids of the buses passing every stop, in the order of bus names and compressed by stop:
+			// buses of stop i are stop_buses_[stop_bus_offsets_[i]] ... stop_buses_[stop_bus_offsets_[i + 1] - 1].
+			// Emptied by every change of stops or buses until BuildStopBuses is called
+			std::vector<uint32_t> stop_bus_offsets_;
+			std::vector<uint32_t> stop_buses_;
+			// Emptied by every change of stops until BuildStopGrid or SetStopGrid is called
+			std::optional<StopGrid> stop_grid_;
+			DistanceTable stop_to_stop_distance_;
 
-		public:
+			// Fills distances along the route and statistics of the bus
+			void ComputeBusDistances(Bus& bus) const;
 
-			void AddStop(const std::string& name, double latitude, double longitude);
-			Stop* FindStop(std::string_view name) const;
+		public:
+			void AddStop(std::string_view name, double latitude, double longitude);
+			std::optional<uint32_t> FindStop(std::string_view name) const;
+			void SetStopCoordinates(uint32_t stop_id, double latitude, double longitude);
+			size_t GetStopCount() const;
+			std::string_view GetStopName(uint32_t stop_id) const;
+			geo::Coordinates GetStopCoordinates(uint32_t stop_id) const;
+			// Coordinates of all stops by stop id
+			const std::vector<double>& GetStopLatitudes() const;
+			const std::vector<double>& GetStopLongitudes() const;
+			// Columns of all stops for batches of distances, valid until a stop is added
+			geo::PointColumns GetStopPoints() const;
+			// A way to or from an unknown stop is ignored
 			void AddWay(std::string_view from_stop, std::string_view to_stop, int distance);
-			int FindWay(std::pair<Stop*, Stop*> from_stop_to_stop) const;
-			const std::unordered_map<std::pair<Stop*, Stop*>, int, PairPtrHasher<Stop, Stop>>& GetAllWays() const;
+			void AddWay(uint32_t from_stop, uint32_t to_stop, int distance);
+			// Road distance between two stops, the reverse way is taken if there is no direct one
+			int FindWay(uint32_t from_stop, uint32_t to_stop) const;
+			const DistanceTable& GetAllWays() const;
 			void AddBus(const std::string& bus, const std::vector<std::string>& stops, bool is_roundtrip, const std::string second_final_stop);
+			// Adds a bus whose distances and statistics are already computed, as a loaded base has them
+			void AddBus(Bus bus);
+			// Recomputes distances and statistics of every bus, needed once stops of existing buses move
+			// or their road distances change
+			void UpdateBusStats();
 			Bus* FindBus(std::string_view name) const;
+			// Invalidates pointers to all buses and views of their names
+			void RemoveBus(std::string_view name);
+			// Indexes the buses of every stop, needed once stops or buses are added or removed
+			void BuildStopBuses();
+			ranges::Range<const uint32_t*> GetStopBuses(uint32_t stop_id) const;
+			// Indexes the coordinates of the stops, needed once stops are added or moved
+			void BuildStopGrid();
+			// Restores the index of a loaded base
+			void SetStopGrid(StopGrid::Data data);
+			const StopGrid& GetStopGrid() const;
+			// At most max_count stops not farther than max_distance meters from the point, nearest first
+			std::vector<NearbyStop> FindNearestStops(geo::Coordinates point, size_t max_count, double max_distance) const;
 			BusInfo GetBusInfo(std::string_view name) const;
 			StopInfo GetStopInfo(std::string_view name) const;
 			const std::deque<Bus>& GetBuses() const;
-            const std::deque<Stop>& GetStops() const;			
 		};
 	}
-}
\ No newline at end of file
+}
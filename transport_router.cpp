@@ -1,6 +1,51 @@
 #include "transport_router.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <thread>
+#include <tuple>
+
 namespace transport_router {
+    RoutingMode ParseRoutingMode(const std::string& routing_mode)
+    {
+		if (routing_mode == "all_pairs"s) {
+			return RoutingMode::ALL_PAIRS;
+		}
+		if (routing_mode == "dijkstra"s) {
+			return RoutingMode::DIJKSTRA;
+		}
+		if (routing_mode == "contraction_hierarchies"s) {
+			return RoutingMode::CONTRACTION_HIERARCHIES;
+		}
+		if (routing_mode == "astar"s) {
+			return RoutingMode::A_STAR;
+		}
+		if (routing_mode == "raptor"s) {
+			return RoutingMode::RAPTOR;
+		}
+		throw std::invalid_argument("Unknown routing mode: "s + routing_mode);
+    }
+
+    std::string RoutingModeToString(RoutingMode routing_mode)
+    {
+		switch (routing_mode)
+		{
+		case RoutingMode::DIJKSTRA:
+			return "dijkstra"s;
+		case RoutingMode::CONTRACTION_HIERARCHIES:
+			return "contraction_hierarchies"s;
+		case RoutingMode::A_STAR:
+			return "astar"s;
+		case RoutingMode::RAPTOR:
+			return "raptor"s;
+		case RoutingMode::ALL_PAIRS:
+		default:
+			return "all_pairs"s;
+		}
+    }
+
     TransportRouter::TransportRouter(const TransportCatalogue &tc)
 		: tc_(tc) {}
 
@@ -9,93 +54,732 @@ namespace transport_router {
 	{
 		bus_wait_time_ = router_settings.at("bus_wait_time"s).AsInt();
 		bus_velocity_ = router_settings.at("bus_velocity"s).AsDouble();
+		if (router_settings.count("routing_mode"s)) {
+			routing_mode_ = ParseRoutingMode(router_settings.at("routing_mode"s).AsString());
+		}
+		if (router_settings.count("build_thread_count"s)) {
+			build_thread_count_ = router_settings.at("build_thread_count"s).AsInt();
+		}
+		if (router_settings.count("route_cache_capacity"s)) {
+			SetRouteCacheCapacity(router_settings.at("route_cache_capacity"s).AsInt());
+		}
+		if (router_settings.count("walking_velocity"s)) {
+			walking_velocity_ = router_settings.at("walking_velocity"s).AsDouble();
+		}
+		if (router_settings.count("walking_stop_count"s)) {
+			walking_stop_count_ = router_settings.at("walking_stop_count"s).AsInt();
+		}
 		MakeGraph();
+		MakeRouter();
+	}
+
+	std::optional<RouteInfo> TransportRouter::BuildRoute(const std::string& from, const std::string& to) const
+	{
+		const graph::VertexId from_id = GetStopVertex(from);
+		const graph::VertexId to_id = GetStopVertex(to);
+		if (!route_cache_) {
+			return ComputeRoute(from_id, to_id);
+		}
+		return route_cache_->GetOrCompute(MakeRouteCacheKey(from_id, to_id)
+			, [&] { return ComputeRoute(from_id, to_id); });
+	}
+
+	std::optional<RouteInfo> TransportRouter::BuildRoute(const RouteEndpoint& from, const RouteEndpoint& to) const
+	{
+		const std::string* from_stop = std::get_if<std::string>(&from);
+		const std::string* to_stop = std::get_if<std::string>(&to);
+		if (from_stop && to_stop) {
+			return BuildRoute(*from_stop, *to_stop);
+		}
+
+		const std::vector<WalkingStop> from_stops = FindWalkingStops(from);
+		const std::vector<WalkingStop> to_stops = FindWalkingStops(to);
+		std::optional<RouteInfo> route;
+		if (auto transit_route = ComputeRoute(from_stops, to_stops)) {
+			const WalkingStop& first_stop = from_stops[transit_route->from_index];
+			const WalkingStop& last_stop = to_stops[transit_route->to_index];
+			route.emplace();
+			if (!from_stop) {
+				route->items.push_back({ EdgeType::WALK, tc_.GetStopName(first_stop.stop_id), 0, first_stop.walk_time });
+			}
+			route->items.insert(route->items.end(), transit_route->route.items.begin(), transit_route->route.items.end());
+			if (!to_stop) {
+				route->items.push_back({ EdgeType::WALK, tc_.GetStopName(last_stop.stop_id), 0, last_stop.walk_time });
+			}
+			route->total_time = first_stop.walk_time + transit_route->route.total_time + last_stop.walk_time;
+		}
+
+		const double walk_time = ComputeWalkTime(geo::ComputeDistance(GetEndpointCoordinates(from), GetEndpointCoordinates(to)));
+		if (route && route->total_time < walk_time) {
+			return route;
+		}
+		std::string_view walk_stop_name;
+		if (from_stop || to_stop) {
+			walk_stop_name = tc_.GetStopName(from_stop ? from_stops.front().stop_id : to_stops.front().stop_id);
+		}
+		return RouteInfo{ walk_time, { { EdgeType::WALK, walk_stop_name, 0, walk_time } } };
+	}
+
+	std::vector<std::optional<RouteInfo>> TransportRouter::BuildRoutesFrom(const std::string& from, const std::vector<std::string>& targets) const
+	{
+		const graph::VertexId from_id = GetStopVertex(from);
+		std::vector<graph::VertexId> target_ids;
+		target_ids.reserve(targets.size());
+		for (const std::string& target : targets) {
+			target_ids.push_back(GetStopVertex(target));
+		}
+		std::vector<std::optional<RouteInfo>> routes(targets.size());
+		// Indexes of the targets whose routes are not cached
+		std::vector<size_t> missing;
+		for (size_t i = 0; i < target_ids.size(); ++i) {
+			if (route_cache_) {
+				if (auto route = route_cache_->Get(MakeRouteCacheKey(from_id, target_ids[i]))) {
+					routes[i] = std::move(*route);
+					continue;
+				}
+			}
+			missing.push_back(i);
+		}
+
+		// Few targets are found faster by the routing engine itself, the table has every answer ready
+		const bool is_guided = routing_mode_ == RoutingMode::CONTRACTION_HIERARCHIES || routing_mode_ == RoutingMode::A_STAR;
+		if (missing.size() < (is_guided ? MIN_GUIDED_TREE_TARGET_COUNT : MIN_TREE_TARGET_COUNT)
+			|| routing_mode_ == RoutingMode::ALL_PAIRS) {
+			for (const size_t i : missing) {
+				routes[i] = ComputeRoute(from_id, target_ids[i]);
+			}
+		}
+		else if (routing_mode_ == RoutingMode::RAPTOR) {
+			std::vector<size_t> to_stops;
+			to_stops.reserve(missing.size());
+			for (const size_t i : missing) {
+				to_stops.push_back(target_ids[i] / 2);
+			}
+			auto journeys = raptor_router_->BuildRoutes(from_id / 2, to_stops);
+			for (size_t k = 0; k < missing.size(); ++k) {
+				routes[missing[k]] = MakeRouteInfo(journeys[k]);
+			}
+		}
+		else {
+			std::vector<graph::VertexId> tree_targets;
+			tree_targets.reserve(missing.size());
+			for (const size_t i : missing) {
+				tree_targets.push_back(target_ids[i]);
+			}
+			const graph::ShortestPathTree<double> tree(graph_, from_id, graph::ShortestPathTree<double>::Direction::FORWARD, tree_targets);
+			for (const size_t i : missing) {
+				routes[i] = MakeRouteInfo(tree.BuildRoute(target_ids[i]));
+			}
+		}
+
+		if (route_cache_) {
+			for (const size_t i : missing) {
+				route_cache_->Put(MakeRouteCacheKey(from_id, target_ids[i]), routes[i]);
+			}
+		}
+		return routes;
+	}
+
+	std::vector<RouteInfo> TransportRouter::BuildAlternativeRoutes(const std::string& from, const std::string& to, size_t max_count
+		, std::optional<std::chrono::milliseconds> latency_budget) const
+	{
+		using Finder = graph::AlternativeRoutesFinder<double>;
+		const auto start = Finder::Clock::now();
+		const graph::VertexId from_id = GetStopVertex(from);
+		const graph::VertexId to_id = GetStopVertex(to);
+		std::vector<RouteInfo> routes;
+		if (max_count == 0) {
+			return routes;
+		}
+		if (routing_mode_ == RoutingMode::RAPTOR) {
+			if (auto route = ComputeRoute(from_id, to_id)) {
+				routes.push_back(std::move(*route));
+			}
+			return routes;
+		}
+
+		// Getting off a bus to board the same bus again only adds a wait, unless the bus turns at a terminal
+		// in between. Such a route is no alternative if one ride of that bus covers both
+		const auto has_no_reboarding = [this](const Finder::RouteInfo& route) {
+			std::optional<graph::EdgeId> last_ride;
+			for (const graph::EdgeId edge_id : route.edges) {
+				const EdgeInfo& edge_info = edge_infos_[edge_id];
+				if (edge_info.type != EdgeType::BUS) {
+					continue;
+				}
+				if (last_ride && edge_infos_[*last_ride].name_id == edge_info.name_id) {
+					const auto outgoing_edges = graph_.GetOutgoingEdges(graph_.GetEdge(*last_ride).from);
+					for (size_t i = 0; i < outgoing_edges.count; ++i) {
+						const EdgeInfo& ride_info = edge_infos_[outgoing_edges.edge_ids[i]];
+						if (outgoing_edges.targets[i] == graph_.GetEdge(edge_id).to
+							&& ride_info.type == EdgeType::BUS && ride_info.name_id == edge_info.name_id) {
+							return false;
+						}
+					}
+				}
+				last_ride = edge_id;
+			}
+			return true;
+		};
+
+		Finder::Settings settings;
+		settings.max_route_count = max_count;
+		const auto deadline = latency_budget ? start + *latency_budget : Finder::Clock::time_point::max();
+		for (const auto& route : Finder(graph_).FindRoutes(from_id, to_id, settings, deadline, has_no_reboarding)) {
+			routes.push_back(std::move(*MakeRouteInfo(route)));
+		}
+		return routes;
+	}
+
+	TransportRouter::TimeMatrix TransportRouter::BuildRoutes(const std::vector<std::string>& sources, const std::vector<std::string>& targets) const
+	{
+		std::vector<graph::VertexId> source_ids;
+		source_ids.reserve(sources.size());
+		for (const std::string& source : sources) {
+			source_ids.push_back(GetStopVertex(source));
+		}
+		std::vector<graph::VertexId> target_ids;
+		target_ids.reserve(targets.size());
+		for (const std::string& target : targets) {
+			target_ids.push_back(GetStopVertex(target));
+		}
+		TimeMatrix matrix(sources.size(), std::vector<std::optional<double>>(targets.size()));
+		if (sources.empty() || targets.empty()) {
+			return matrix;
+		}
+
+		switch (routing_mode_)
+		{
+		case RoutingMode::ALL_PAIRS:
+			// Every answer is already in the table
+			for (size_t i = 0; i < source_ids.size(); ++i) {
+				for (size_t j = 0; j < target_ids.size(); ++j) {
+					if (const auto route = router_->BuildRoute(source_ids[i], target_ids[j])) {
+						matrix[i][j] = route->weight;
+					}
+				}
+			}
+			break;
+		case RoutingMode::RAPTOR:
+			// Rounds run forward in time only, so there is one search per source
+			for (size_t i = 0; i < source_ids.size(); ++i) {
+				const auto arrivals = raptor_router_->ComputeArrivalTimes(source_ids[i] / 2);
+				for (size_t j = 0; j < target_ids.size(); ++j) {
+					matrix[i][j] = arrivals[target_ids[j] / 2];
+				}
+			}
+			break;
+		default:
+			// One Dijkstra tree over the graph per source, or a backward one per target if there are fewer targets
+			using Tree = graph::ShortestPathTree<double>;
+			if (source_ids.size() <= target_ids.size()) {
+				for (size_t i = 0; i < source_ids.size(); ++i) {
+					const Tree tree(graph_, source_ids[i], Tree::Direction::FORWARD, target_ids);
+					for (size_t j = 0; j < target_ids.size(); ++j) {
+						matrix[i][j] = tree.GetWeight(target_ids[j]);
+					}
+				}
+			}
+			else {
+				for (size_t j = 0; j < target_ids.size(); ++j) {
+					const Tree tree(graph_, target_ids[j], Tree::Direction::BACKWARD, source_ids);
+					for (size_t i = 0; i < source_ids.size(); ++i) {
+						matrix[i][j] = tree.GetWeight(source_ids[i]);
+					}
+				}
+			}
+			break;
+		}
+		return matrix;
+	}
+
+	std::vector<ReachableStop> TransportRouter::BuildReachableStops(const std::string& from, double max_time) const
+	{
+		const graph::VertexId from_id = GetStopVertex(from);
+		const size_t stop_count = tc_.GetStopCount();
+		// Modes sum the same weights in different orders, a stop right at the budget must not depend on it
+		max_time += REACHABLE_TIME_TOLERANCE;
+		std::vector<ReachableStop> reachable_stops;
+		switch (routing_mode_)
+		{
+		case RoutingMode::ALL_PAIRS:
+		{
+			// The row of the table has every answer
+			const auto& routes_internal_data = GetRoutesInternalData();
+			for (uint32_t stop_id = 0; stop_id < stop_count; ++stop_id) {
+				const graph::VertexId vertex = GetArrivalVertex(stop_id);
+				if (routes_internal_data.HasRoute(from_id, vertex) && routes_internal_data.GetWeight(from_id, vertex) <= max_time) {
+					reachable_stops.push_back({ tc_.GetStopName(stop_id), routes_internal_data.GetWeight(from_id, vertex) });
+				}
+			}
+			break;
+		}
+		case RoutingMode::RAPTOR:
+		{
+			const auto arrivals = raptor_router_->ComputeArrivalTimes(from_id / 2, max_time);
+			for (uint32_t stop_id = 0; stop_id < stop_count; ++stop_id) {
+				if (arrivals[stop_id]) {
+					reachable_stops.push_back({ tc_.GetStopName(stop_id), *arrivals[stop_id] });
+				}
+			}
+			break;
+		}
+		default:
+		{
+			using Tree = graph::ShortestPathTree<double>;
+			const Tree tree(graph_, from_id, Tree::Direction::FORWARD, {}, max_time);
+			// Buses arrive at the even vertices, odd ones are only reached through the wait at the stop
+			for (const graph::VertexId vertex : tree.GetSettledVertices()) {
+				if (vertex % 2 == 0) {
+					reachable_stops.push_back({ tc_.GetStopName(vertex / 2), *tree.GetWeight(vertex) });
+				}
+			}
+			break;
+		}
+		}
+
+		std::sort(reachable_stops.begin(), reachable_stops.end(), [](const ReachableStop& lhs, const ReachableStop& rhs) {
+			return std::pair{ lhs.time, lhs.name } < std::pair{ rhs.time, rhs.name };
+		});
+		return reachable_stops;
+	}
+
+	uint64_t TransportRouter::MakeRouteCacheKey(graph::VertexId from_id, graph::VertexId to_id)
+	{
+		return (static_cast<uint64_t>(from_id) << 32) | to_id;
+	}
+
+	std::optional<RouteInfo> TransportRouter::ComputeRoute(graph::VertexId from_id, graph::VertexId to_id) const
+	{
+		if (routing_mode_ == RoutingMode::RAPTOR) {
+			// Stop ids are the ids of the stops' arrival vertices, two vertices per stop
+			return MakeRouteInfo(raptor_router_->BuildRoute(from_id / 2, to_id / 2));
+		}
+		return MakeRouteInfo(router_->BuildRoute(from_id, to_id));
+	}
+
+	std::optional<TransportRouter::TransitRoute> TransportRouter::ComputeRoute(const std::vector<WalkingStop>& from_stops
+		, const std::vector<WalkingStop>& to_stops) const
+	{
+		std::optional<TransitRoute> best_route;
+		switch (routing_mode_)
+		{
+		case RoutingMode::ALL_PAIRS:
+		{
+			// Every pair is already in the table
+			double best_time = 0;
+			for (size_t i = 0; i < from_stops.size(); ++i) {
+				for (size_t j = 0; j < to_stops.size(); ++j) {
+					auto route = ComputeRoute(GetArrivalVertex(from_stops[i].stop_id), GetArrivalVertex(to_stops[j].stop_id));
+					if (!route) {
+						continue;
+					}
+					const double time = from_stops[i].walk_time + route->total_time + to_stops[j].walk_time;
+					if (!best_route || time < best_time) {
+						best_route = TransitRoute{ i, j, std::move(*route) };
+						best_time = time;
+					}
+				}
+			}
+			break;
+		}
+		case RoutingMode::RAPTOR:
+		{
+			std::vector<RaptorRouter::StopTime> from_times;
+			for (const WalkingStop& stop : from_stops) {
+				from_times.push_back({ stop.stop_id, stop.walk_time });
+			}
+			std::vector<RaptorRouter::StopTime> to_times;
+			for (const WalkingStop& stop : to_stops) {
+				to_times.push_back({ stop.stop_id, stop.walk_time });
+			}
+			const auto journey = raptor_router_->BuildRoute(from_times, to_times);
+			if (!journey) {
+				break;
+			}
+			// Stops of one endpoint are distinct, so the journey's stops tell their indexes
+			const auto find_index = [](const std::vector<WalkingStop>& stops, size_t stop_id) {
+				return static_cast<size_t>(std::find_if(stops.begin(), stops.end(), [stop_id](const WalkingStop& stop) {
+					return stop.stop_id == stop_id;
+				}) - stops.begin());
+			};
+			best_route = TransitRoute{ find_index(from_stops, journey->from_stop), find_index(to_stops, journey->to_stop), *MakeRouteInfo(journey) };
+			break;
+		}
+		default:
+		{
+			// Contraction hierarchies and A* answer a single pair only, so the plain graph is searched
+			std::vector<graph::WeightedVertex<double>> sources;
+			for (const WalkingStop& stop : from_stops) {
+				sources.push_back({ GetArrivalVertex(stop.stop_id), stop.walk_time });
+			}
+			std::vector<graph::WeightedVertex<double>> targets;
+			for (const WalkingStop& stop : to_stops) {
+				targets.push_back({ GetArrivalVertex(stop.stop_id), stop.walk_time });
+			}
+			if (auto route = graph::BuildRouteBetweenSets(graph_, sources, targets)) {
+				best_route = TransitRoute{ route->source_index, route->target_index, *MakeRouteInfo(route->route) };
+			}
+			break;
+		}
+		}
+		return best_route;
+	}
+
+	std::optional<RouteInfo> TransportRouter::MakeRouteInfo(const std::optional<RaptorRouter::Journey>& journey) const
+	{
+		if (!journey) {
+			return std::nullopt;
+		}
+		RouteInfo route_info;
+		for (const auto& leg : journey->legs) {
+			route_info.items.push_back({ EdgeType::WAIT, tc_.GetStopName(leg.board_stop), 0, static_cast<double>(bus_wait_time_) });
+			route_info.items.push_back({ EdgeType::BUS, leg.bus->name, leg.span_count, leg.ride_time });
+		}
+		route_info.total_time = journey->total_time;
+		return route_info;
+	}
+
+	std::optional<RouteInfo> TransportRouter::MakeRouteInfo(const std::optional<graph::RoutingEngine<double>::RouteInfo>& route) const
+	{
+		if (!route) {
+			return std::nullopt;
+		}
+		RouteInfo route_info;
+		for (const graph::EdgeId edge_id : route->edges) {
+			const auto [edge, edge_info] = GetFullEdgeInfo(edge_id);
+			route_info.items.push_back({ edge_info.type, GetEdgeName(edge_info), edge_info.span_count, edge.weight });
+		}
+		route_info.total_time = route->weight;
+		return route_info;
 	}
 
-	std::optional<graph::Router<double>::RouteInfo> TransportRouter::BuildRoute(const std::string& from, const std::string& to) const
+	graph::VertexId TransportRouter::GetArrivalVertex(uint32_t stop_id)
 	{
-		return router_.get()->BuildRoute(stopname_to_stop_id_.at(from), stopname_to_stop_id_.at(to));
+		return static_cast<graph::VertexId>(stop_id) * 2;
+	}
+
+	graph::VertexId TransportRouter::GetDepartureVertex(uint32_t stop_id)
+	{
+		return static_cast<graph::VertexId>(stop_id) * 2 + 1;
+	}
+
+	std::vector<TransportRouter::WalkingStop> TransportRouter::FindWalkingStops(const RouteEndpoint& endpoint) const
+	{
+		std::vector<WalkingStop> stops;
+		if (const std::string* stop_name = std::get_if<std::string>(&endpoint)) {
+			stops.push_back({ static_cast<uint32_t>(GetStopVertex(*stop_name) / 2), 0 });
+			return stops;
+		}
+		const auto nearest_stops = tc_.GetStopGrid().FindNearest(std::get<geo::Coordinates>(endpoint), walking_stop_count_
+			, std::numeric_limits<double>::infinity(), tc_.GetStopPoints());
+		for (const auto& [stop_id, distance] : nearest_stops) {
+			stops.push_back({ stop_id, ComputeWalkTime(distance) });
+		}
+		return stops;
+	}
+
+	geo::Coordinates TransportRouter::GetEndpointCoordinates(const RouteEndpoint& endpoint) const
+	{
+		if (const std::string* stop_name = std::get_if<std::string>(&endpoint)) {
+			return tc_.GetStopCoordinates(static_cast<uint32_t>(GetStopVertex(*stop_name) / 2));
+		}
+		return std::get<geo::Coordinates>(endpoint);
+	}
+
+	graph::VertexId TransportRouter::GetStopVertex(std::string_view stop_name) const
+	{
+		const auto stop_id = tc_.FindStop(stop_name);
+		if (!stop_id) {
+			throw std::out_of_range("Unknown stop: "s + std::string(stop_name));
+		}
+		return GetArrivalVertex(*stop_id);
 	}
 
 	void TransportRouter::MakeGraph()
 	{
-		const std::deque<transport_catalogue::data_base::Stop>& all_stops = tc_.GetStops();
-		size_t vertex_count = all_stops.size() * 2;
+		const size_t stop_count = tc_.GetStopCount();
+		size_t vertex_count = stop_count * 2;
 		graph::DirectedWeightedGraph<double> graph(vertex_count);
 		graph_ = std::move(graph);
+		edge_infos_.clear();
 
-		AddAllWaitEdges(all_stops);
+		AddAllWaitEdges(stop_count);
 		
 		const std::deque<transport_catalogue::data_base::Bus>& all_buses = tc_.GetBuses();
 
-		for (const auto& bus : all_buses) {
-			switch (bus.type)
-			{
-			case transport_catalogue::data_base::RouteType::CIRCLE:
-				AddCircleBusEdges(bus);
-				break;
-			case transport_catalogue::data_base::RouteType::TWO_DIRECTIONAL:
-				AddLineBusEdges(bus);
-				break;
+		// In raptor mode rides are searched over the bus routes themselves, no edges are needed for them
+		if (routing_mode_ != RoutingMode::RAPTOR) {
+			for (uint32_t bus_id = 0; bus_id < all_buses.size(); ++bus_id) {
+				const Bus& bus = all_buses[bus_id];
+				switch (bus.type)
+				{
+				case transport_catalogue::data_base::RouteType::CIRCLE:
+					AddCircleBusEdges(bus_id, bus);
+					break;
+				case transport_catalogue::data_base::RouteType::TWO_DIRECTIONAL:
+					AddLineBusEdges(bus_id, bus);
+					break;
+				}
 			}
-		}	
-		router_ = std::make_unique<graph::Router<double>>(graph_);
+		}
+		graph_.Freeze();
+	}
+
+	void TransportRouter::UpdateGraph(graph::DirectedWeightedGraph<double> previous_graph, RouterData previous_data
+		, const std::vector<std::string>& previous_bus_names)
+	{
+		const std::vector<EdgeInfo> previous_edge_infos = std::move(edge_infos_);
+		SetRouteCacheCapacity(route_cache_capacity_);
+		MakeGraph();
+
+		if (routing_mode_ != RoutingMode::ALL_PAIRS || previous_data.routes_internal_data.GetVertexCount() == 0) {
+			// The other modes need little or no preprocessing, contraction hierarchies are rebuilt as a whole
+			MakeRouter();
+			return;
+		}
+		const graph::GraphChange change = MatchPreviousEdges(previous_graph, previous_edge_infos, previous_bus_names);
+		router_ = std::make_unique<AllPairsRouter>(graph_, graph::UpdateRoutesInternalData(graph_
+			, previous_data.routes_internal_data, change, GetBuildThreadCount()));
 	}
 
-	void TransportRouter::AddAllWaitEdges(const std::deque<transport_catalogue::data_base::Stop>& all_stops)
+	void TransportRouter::SetRoutingMetric(const json::Dict& routing_settings)
 	{
-		graph::VertexId stop_id = 0;
+		if (routing_settings.count("walking_velocity"s)) {
+			SetWalkingVelocity(routing_settings.at("walking_velocity"s).AsDouble());
+		}
+		if (routing_settings.count("walking_stop_count"s)) {
+			SetWalkingStopCount(routing_settings.at("walking_stop_count"s).AsInt());
+		}
+		SetRoutingMetric(routing_settings.count("bus_wait_time"s) ? routing_settings.at("bus_wait_time"s).AsInt() : bus_wait_time_
+			, routing_settings.count("bus_velocity"s) ? routing_settings.at("bus_velocity"s).AsDouble() : bus_velocity_);
+	}
 
-		for (const auto& stop : all_stops) {
-			stopname_to_stop_id_[stop.name] = stop_id;
-			graph::EdgeId edge_id = graph_.AddEdge({ stop_id++, stop_id++, static_cast<double>(bus_wait_time_) });
+	void TransportRouter::SetRoutingMetric(int bus_wait_time, double bus_velocity)
+	{
+		if (bus_wait_time == bus_wait_time_ && bus_velocity == bus_velocity_) {
+			return;
+		}
+		bus_wait_time_ = bus_wait_time;
+		bus_velocity_ = bus_velocity;
+		SetRouteCacheCapacity(route_cache_capacity_);
+
+		// The topology stays: same edges in the same compressed rows, only with new weights
+		std::vector<graph::Edge<double>> edges;
+		edges.reserve(graph_.GetEdgeCount());
+		for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+			const EdgeInfo& edge_info = edge_infos_[edge_id];
+			graph::Edge<double> edge = graph_.GetEdge(edge_id);
+			edge.weight = edge_info.type == EdgeType::WAIT ? static_cast<double>(bus_wait_time_) : ComputeRideTime(edge_info.distance);
+			edges.push_back(edge);
+		}
+		graph::DirectedWeightedGraph<double> graph(std::move(edges), graph_.GetOffsets(), graph_.GetOutgoingEdgeIds());
+
+		switch (routing_mode_)
+		{
+		case RoutingMode::CONTRACTION_HIERARCHIES:
+		{
+			const std::vector<uint32_t> ranks = GetContractionHierarchy().ranks;
+			router_.reset();
+			graph_ = std::move(graph);
+			router_ = std::make_unique<ContractionHierarchy>(graph_, ranks);
+			break;
+		}
+		case RoutingMode::ALL_PAIRS:
+			router_.reset();
+			graph_ = std::move(graph);
+			router_ = std::make_unique<AllPairsRouter>(graph_
+				, graph::ComputeRoutesInternalData<double, AllPairsRouter::RoutesInternalData>(graph_, GetBuildThreadCount()));
+			break;
+		default:
+			graph_ = std::move(graph);
+			MakeRouter();
+			break;
+		}
+	}
+
+	// Edges are matched by their ends, weight and meaning, so an edge whose weight changed
+	// counts as removed and added again
+	graph::GraphChange TransportRouter::MatchPreviousEdges(const graph::DirectedWeightedGraph<double>& previous_graph
+		, const std::vector<EdgeInfo>& previous_edge_infos, const std::vector<std::string>& previous_bus_names) const
+	{
+		// Stops are never removed, so waits keep their stop indexes, while rides are matched by bus names
+		using EdgeKey = std::tuple<graph::VertexId, graph::VertexId, double, EdgeType, uint32_t, std::string_view, int>;
+		const auto make_key = [](const graph::Edge<double>& edge, const EdgeInfo& edge_info, std::string_view bus_name) {
+			return EdgeKey{ edge.from, edge.to, edge.weight, edge_info.type
+				, edge_info.type == EdgeType::WAIT ? edge_info.name_id : 0, bus_name, edge_info.span_count };
+		};
+
+		// Current edges by key, the same key may repeat if a bus passes a span twice
+		std::map<EdgeKey, std::vector<graph::EdgeId>> current_edges;
+		for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+			const EdgeInfo& edge_info = edge_infos_[edge_id];
+			current_edges[make_key(graph_.GetEdge(edge_id), edge_info
+				, edge_info.type == EdgeType::BUS ? GetEdgeName(edge_info) : std::string_view{})].push_back(edge_id);
+		}
+		for (auto& [key, edge_ids] : current_edges) {
+			std::reverse(edge_ids.begin(), edge_ids.end());
+		}
+
+		graph::GraphChange change;
+		change.edge_ids.resize(previous_graph.GetEdgeCount());
+		std::vector<bool> is_matched(graph_.GetEdgeCount(), false);
+		for (graph::EdgeId edge_id = 0; edge_id < previous_graph.GetEdgeCount(); ++edge_id) {
+			const EdgeInfo& edge_info = previous_edge_infos.at(edge_id);
+			const auto it = current_edges.find(make_key(previous_graph.GetEdge(edge_id), edge_info
+				, edge_info.type == EdgeType::BUS ? std::string_view(previous_bus_names.at(edge_info.name_id)) : std::string_view{}));
+			if (it == current_edges.end() || it->second.empty()) {
+				continue;
+			}
+			change.edge_ids[edge_id] = it->second.back();
+			is_matched[it->second.back()] = true;
+			it->second.pop_back();
+		}
+		for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+			if (!is_matched[edge_id]) {
+				change.added_edges.push_back(edge_id);
+			}
+		}
+		return change;
+	}
+
+	void TransportRouter::MakeRouter()
+	{
+		switch (routing_mode_)
+		{
+		case RoutingMode::DIJKSTRA:
+			router_ = std::make_unique<graph::DijkstraRouter<double>>(graph_);
+			break;
+		case RoutingMode::CONTRACTION_HIERARCHIES:
+			router_ = std::make_unique<ContractionHierarchy>(graph_);
+			break;
+		case RoutingMode::A_STAR:
+			router_ = std::make_unique<graph::AStarRouter<double>>(graph_, MakeGeoLowerBound());
+			break;
+		case RoutingMode::RAPTOR:
+			raptor_router_ = std::make_unique<RaptorRouter>(tc_, bus_wait_time_, bus_velocity_);
+			break;
+		case RoutingMode::ALL_PAIRS:
+			router_ = std::make_unique<AllPairsRouter>(graph_, GetBuildThreadCount());
+			break;
+		}
+	}
+
+	size_t TransportRouter::GetBuildThreadCount() const
+	{
+		return build_thread_count_ != 0 ? build_thread_count_ : std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	double TransportRouter::ComputeRideTime(int distance) const
+	{
+		const double conversion_ratio = 1000.0 / 60.0;		// convertion from km/h to m/min
+		return distance / (bus_velocity_ * conversion_ratio);
+	}
+
+	double TransportRouter::ComputeWalkTime(double distance) const
+	{
+		const double conversion_ratio = 1000.0 / 60.0;		// convertion from km/h to m/min
+		return distance / (walking_velocity_ * conversion_ratio);
+	}
+
+	// Great-circle distance divided by the speed. Road distances may be shorter than the
+	// great-circle ones, so the speed is raised to the fastest straight-line speed over
+	// all edges: the bound never exceeds an edge weight and stays consistent
+	graph::AStarRouter<double>::LowerBound TransportRouter::MakeGeoLowerBound() const
+	{
+		// Stops are added only before the graph is built anew, which makes a new bound
+		const geo::PointColumns points = tc_.GetStopPoints();
+
+		// Distances of the edges are computed in batches, the ends of an edge are the stops of its vertices
+		constexpr size_t BATCH_SIZE = 1024;
+		std::vector<uint32_t> from_stops;
+		std::vector<uint32_t> to_stops;
+		std::vector<double> distances(BATCH_SIZE);
+		double max_speed = bus_velocity_ * 1000.0 / 60.0;		// m/min
+		for (graph::EdgeId batch_begin = 0; batch_begin < graph_.GetEdgeCount(); batch_begin += BATCH_SIZE) {
+			const graph::EdgeId batch_end = static_cast<graph::EdgeId>(std::min<size_t>(graph_.GetEdgeCount(), batch_begin + BATCH_SIZE));
+			from_stops.clear();
+			to_stops.clear();
+			for (graph::EdgeId edge_id = batch_begin; edge_id < batch_end; ++edge_id) {
+				from_stops.push_back(graph_.GetEdge(edge_id).from / 2);
+				to_stops.push_back(graph_.GetEdge(edge_id).to / 2);
+			}
+			geo::ComputeDistances(points, from_stops.data(), to_stops.data(), from_stops.size(), distances.data());
+			for (graph::EdgeId edge_id = batch_begin; edge_id < batch_end; ++edge_id) {
+				const double distance = distances[edge_id - batch_begin];
+				const double weight = graph_.GetEdge(edge_id).weight;
+				if (distance > 0) {
+					max_speed = std::max(max_speed, weight > 0 ? distance / weight : std::numeric_limits<double>::infinity());
+				}
+			}
+		}
+
+		return [points, max_speed](graph::VertexId from, graph::VertexId to) {
+			return std::isinf(max_speed) ? 0.0 : geo::ComputeDistance(points, from / 2, to / 2) / max_speed;
+		};
+	}
+
+	void TransportRouter::AddAllWaitEdges(size_t stop_count)
+	{
+		// Edge ids are given in order, so an edge's info is pushed right after the edge
+		for (uint32_t stop_id = 0; stop_id < stop_count; ++stop_id) {
 			EdgeInfo edge_info;
 			edge_info.type = EdgeType::WAIT;
-			edge_info.stop_name = stop.name;
-			edge_id_to_info_[edge_id] = std::move(edge_info);
+			edge_info.name_id = stop_id;
+			graph_.AddEdge({ GetArrivalVertex(stop_id), GetDepartureVertex(stop_id), static_cast<double>(bus_wait_time_) });
+			edge_infos_.push_back(edge_info);
 		}
 	}
 
-	void TransportRouter::AddBusEdges(const Bus& bus, std::vector<Stop*>::const_iterator begin,  std::vector<Stop*>::const_iterator end) {
-		double conversion_ratio = 1000.0 / 60.0;		// convertion from km/h to m/min
-		for (auto item = begin; item != end - 1; ++item) {
-			int span_count = 0;
-			double distance = 0;
-			auto prev = item;
-			for (auto it = item + 1; it != end; ++it) {
-				++span_count;
+	void TransportRouter::AddBusEdges(uint32_t bus_id, const Bus& bus, size_t begin, size_t end) {
+		// The road distance between any two stops of the route is a difference of its prefix sums
+		for (size_t from = begin; from + 1 < end; ++from) {
+			for (size_t to = from + 1; to < end; ++to) {
 				EdgeInfo edge_info;
 				edge_info.type = EdgeType::BUS;
-				edge_info.bus = bus.name;
-				edge_info.span_count = span_count;
-				distance += tc_.FindWay({ *prev, *it });
-				prev = it;
-				graph::EdgeId edge_id = graph_.AddEdge({ stopname_to_stop_id_.at((*item)->name) + 1
-					, stopname_to_stop_id_.at((*it)->name)
-					, ((distance) / (bus_velocity_ * conversion_ratio)) });
-				edge_id_to_info_[edge_id] = std::move(edge_info);
+				edge_info.name_id = bus_id;
+				edge_info.span_count = static_cast<int>(to - from);
+				edge_info.distance = bus.road_distances[to] - bus.road_distances[from];
+				graph_.AddEdge({ GetDepartureVertex(bus.stops[from]), GetArrivalVertex(bus.stops[to]), ComputeRideTime(edge_info.distance) });
+				edge_infos_.push_back(edge_info);
 			}
 		}
 	}
 
-	void TransportRouter::AddCircleBusEdges(const Bus& bus) {
-		AddBusEdges(bus, bus.stops.cbegin(), bus.stops.cend());
+	void TransportRouter::AddCircleBusEdges(uint32_t bus_id, const Bus& bus) {
+		AddBusEdges(bus_id, bus, 0, bus.stops.size());
 	}
 
-	void TransportRouter::AddLineBusEdges(const Bus& bus) {
-		size_t mid_num = bus.stops.size() / 2;
-		std::vector<Stop* >::const_iterator mid = bus.stops.begin() + mid_num;
-		AddBusEdges(bus, bus.stops.cbegin(), mid + 1);
-		AddBusEdges(bus, mid, bus.stops.cend());
+	void TransportRouter::AddLineBusEdges(uint32_t bus_id, const Bus& bus) {
+		const size_t mid = bus.stops.size() / 2;
+		AddBusEdges(bus_id, bus, 0, mid + 1);
+		AddBusEdges(bus_id, bus, mid, bus.stops.size());
 	}
     
 	std::pair<const graph::Edge<double>&, const transport_router::EdgeInfo&> TransportRouter::GetFullEdgeInfo(graph::EdgeId edge_id) const {
-		return { graph_.GetEdge(edge_id), edge_id_to_info_.at(edge_id) };
+		return { graph_.GetEdge(edge_id), edge_infos_.at(edge_id) };
 	}
     void TransportRouter::SetGraph(graph::DirectedWeightedGraph<double> graph)
     {
+		SetRouteCacheCapacity(route_cache_capacity_);
 		graph_ = std::move(graph);
-		router_ = std::make_unique<graph::Router<double>>(graph_);
+		graph_.Freeze();
+		MakeRouter();
+    }
+    void TransportRouter::SetGraph(graph::DirectedWeightedGraph<double> graph, RouterData router_data)
+    {
+		SetRouteCacheCapacity(route_cache_capacity_);
+		graph_ = std::move(graph);
+		graph_.Freeze();
+		if (routing_mode_ == RoutingMode::ALL_PAIRS && router_data.routes_internal_data.GetVertexCount() != 0) {
+			router_ = std::make_unique<AllPairsRouter>(graph_, std::move(router_data.routes_internal_data));
+		}
+		else if (routing_mode_ == RoutingMode::CONTRACTION_HIERARCHIES && !router_data.hierarchy.ranks.empty()) {
+			router_ = std::make_unique<ContractionHierarchy>(graph_, std::move(router_data.hierarchy));
+		}
+		else {
+			MakeRouter();
+		}
     }
     void TransportRouter::SetBusWaitTime(int bus_wait_time)
     {
@@ -105,13 +789,26 @@ namespace transport_router {
     {
 		bus_velocity_ = bus_velocity;
     }
-    void TransportRouter::SetStopnameToStopIdMap(std::map<std::string, graph::VertexId> stopname_to_stop_id)
+    void TransportRouter::SetWalkingVelocity(double walking_velocity)
     {
-		stopname_to_stop_id_ = std::move(stopname_to_stop_id);
+		walking_velocity_ = walking_velocity;
     }
-    void TransportRouter::SetEdgeIdToInfoMap(std::map<graph::EdgeId, EdgeInfo> edge_id_to_info)
+    void TransportRouter::SetWalkingStopCount(size_t walking_stop_count)
     {
-		edge_id_to_info_ = std::move(edge_id_to_info);
+		walking_stop_count_ = walking_stop_count;
+    }
+    void TransportRouter::SetRoutingMode(RoutingMode routing_mode)
+    {
+		routing_mode_ = routing_mode;
+    }
+    void TransportRouter::SetRouteCacheCapacity(size_t route_cache_capacity)
+    {
+		route_cache_capacity_ = route_cache_capacity;
+		route_cache_ = route_cache_capacity != 0 ? std::make_unique<RouteCache>(route_cache_capacity) : nullptr;
+    }
+    void TransportRouter::SetEdgeInfos(std::vector<EdgeInfo> edge_infos)
+    {
+		edge_infos_ = std::move(edge_infos);
     }
     const graph::DirectedWeightedGraph<double>& TransportRouter::GetGraph() const
     {
@@ -125,12 +822,46 @@ namespace transport_router {
     {
         return bus_velocity_;
     }
-    const std::map<std::string, graph::VertexId>& TransportRouter::GetStopnameToStopIdMap() const
+    double TransportRouter::GetWalkingVelocity() const
+    {
+        return walking_velocity_;
+    }
+    size_t TransportRouter::GetWalkingStopCount() const
+    {
+        return walking_stop_count_;
+    }
+    RoutingMode TransportRouter::GetRoutingMode() const
+    {
+        return routing_mode_;
+    }
+    size_t TransportRouter::GetRouteCacheCapacity() const
+    {
+        return route_cache_capacity_;
+    }
+    TransportRouter::RouteCache::Stats TransportRouter::GetRouteCacheStats() const
+    {
+        return route_cache_ ? route_cache_->GetStats() : RouteCache::Stats{};
+    }
+    const std::vector<EdgeInfo>& TransportRouter::GetEdgeInfos() const
+    {
+        return edge_infos_;
+    }
+    std::string_view TransportRouter::GetEdgeName(const EdgeInfo& edge_info) const
+    {
+        return edge_info.type == EdgeType::WAIT ? tc_.GetStopName(edge_info.name_id) : tc_.GetBuses().at(edge_info.name_id).name;
+    }
+    const AllPairsRouter::RoutesInternalData& TransportRouter::GetRoutesInternalData() const
     {
-        return stopname_to_stop_id_;
+        if (routing_mode_ != RoutingMode::ALL_PAIRS) {
+            throw std::logic_error("Routes internal data exists only in all_pairs routing mode"s);
+        }
+        return static_cast<const AllPairsRouter&>(*router_).GetRoutesInternalData();
     }
-    const std::map<graph::EdgeId, EdgeInfo>& TransportRouter::GetEdgeIdToInfoMap() const
+    const ContractionHierarchy::Hierarchy& TransportRouter::GetContractionHierarchy() const
     {
-        return edge_id_to_info_;
+        if (routing_mode_ != RoutingMode::CONTRACTION_HIERARCHIES) {
+            throw std::logic_error("Contraction hierarchy exists only in contraction_hierarchies routing mode"s);
+        }
+        return static_cast<const ContractionHierarchy&>(*router_).GetHierarchy();
     }
 }
@@ -1,9 +1,17 @@
 #pragma once
 
-#include <map>
+#include <chrono>
 #include <memory>
+#include <variant>
 
 #include "router.h"
+#include "dijkstra_router.h"
+#include "contraction_hierarchy.h"
+#include "astar_router.h"
+#include "alternative_routes.h"
+#include "routes_update.h"
+#include "raptor_router.h"
+#include "lru_cache.h"
 #include "transport_catalogue.h"
 #include "json.h"
 
@@ -14,61 +22,216 @@ namespace transport_router {
 	{
 		WAIT,
 		BUS,
+		// Only in found routes, the graph has no walking edges
+		WALK,
 	};
 
 
+	// Way of answering route queries, set by "routing_mode" in routing_settings
+	enum class RoutingMode
+	{
+		ALL_PAIRS,
+		DIJKSTRA,
+		CONTRACTION_HIERARCHIES,
+		A_STAR,
+		RAPTOR,
+	};
+
+	using AllPairsRouter = graph::Router<double, graph::FlatRoutesStorage<double>>;
+	using ContractionHierarchy = graph::ContractionHierarchy<double>;
+
+	// Routing engine data precomputed by make_base and restored from the base.
+	// Only the part of the current routing mode is filled.
+	struct RouterData
+	{
+		AllPairsRouter::RoutesInternalData routes_internal_data{};
+		ContractionHierarchy::Hierarchy hierarchy{};
+	};
+
+	RoutingMode ParseRoutingMode(const std::string& routing_mode);
+	std::string RoutingModeToString(RoutingMode routing_mode);
+
+	// Meaning of a graph edge. The router keeps one per edge id in a dense array
 	struct EdgeInfo
 	{
 		EdgeType type{};
-		std::string stop_name{};
-		std::string bus{};
+		// Index of the stop of a wait or of the bus of a ride among the catalogue's stops or buses
+		uint32_t name_id = 0;
         int span_count = 0;
+		// Road distance of a ride in meters. Unlike the weight, it does not depend on routing settings
+		int distance = 0;
+	};
+
+	// One item of a found route, as it is printed in the answer to a Route request
+	struct RouteItem
+	{
+		EdgeType type{};
+		// Stop name for a wait, bus name for a ride. For a walk, the stop it starts or ends at,
+		// empty if it goes between two points
+		std::string_view name{};
+		int span_count = 0;
+		double time = 0;
+	};
+
+	struct RouteInfo
+	{
+		double total_time = 0;
+		std::vector<RouteItem> items;
+	};
+
+	// End of a route: a stop by its name or a point walked to or from some of the stops nearest to it
+	using RouteEndpoint = std::variant<std::string, geo::Coordinates>;
+
+	// Stop reachable within a time budget and the total time of the fastest route to it
+	struct ReachableStop
+	{
+		std::string_view name{};
+		double time = 0;
 	};
     
 	class TransportRouter {
 	public:
+		// Answers of recent Route requests by (from, to) vertex pair, "not found" included
+		using RouteCache = lru_cache::ShardedLruCache<uint64_t, std::optional<RouteInfo>>;
+
+		static constexpr size_t DEFAULT_ROUTE_CACHE_CAPACITY = 1 << 14;
+		// Fewer targets of one origin are searched one by one rather than with a shortest path tree.
+		// Contraction hierarchies and A* answer a single pair much faster than a plain search does
+		static constexpr size_t MIN_TREE_TARGET_COUNT = 2;
+		static constexpr size_t MIN_GUIDED_TREE_TARGET_COUNT = 8;
+		// Minutes a reachable stop may exceed the time budget by, which absorbs rounding of summed weights
+		static constexpr double REACHABLE_TIME_TOLERANCE = 1e-6;
+		static constexpr double DEFAULT_WALKING_VELOCITY = 5;		// km/h
+		static constexpr size_t DEFAULT_WALKING_STOP_COUNT = 3;
+
+		// Total times of routes from every source (rows) to every target (columns), empty if there is no route
+		using TimeMatrix = std::vector<std::vector<std::optional<double>>>;
 
 		using TransportCatalogue = transport_catalogue::data_base::TransportCatalogue;
-		using Stop = transport_catalogue::data_base::Stop;
 		using Bus = transport_catalogue::data_base::Bus;
 
 		TransportRouter(const TransportCatalogue& tc);
 
 		TransportRouter(const TransportCatalogue& tc, const json::Dict& router_settings);
 
-		std::optional<graph::Router<double>::RouteInfo> BuildRoute(const std::string& from, const std::string& to) const;
+		std::optional<RouteInfo> BuildRoute(const std::string& from, const std::string& to) const;
+		// Route between two endpoints. A point is walked to or from one of its walking_stop_count nearest
+		// stops, and the best of all their pairs is found by one search started from every stop of the start.
+		// Walking straight from one endpoint to the other is chosen if it is not slower. Such routes are not cached
+		std::optional<RouteInfo> BuildRoute(const RouteEndpoint& from, const RouteEndpoint& to) const;
+		// Routes from one stop to each of the targets, in their order, grown as one shortest path tree
+		std::vector<std::optional<RouteInfo>> BuildRoutesFrom(const std::string& from, const std::vector<std::string>& targets) const;
+		// Up to max_count diverse routes, shortest first. The search of alternatives stops once the latency
+		// budget is spent, the shortest route is always found. Raptor mode has no bus edges in the graph
+		// and finds the shortest route only
+		std::vector<RouteInfo> BuildAlternativeRoutes(const std::string& from, const std::string& to, size_t max_count
+			, std::optional<std::chrono::milliseconds> latency_budget) const;
+		// Computes all the pairs at once, with one search per source or per target, whichever are fewer
+		TimeMatrix BuildRoutes(const std::vector<std::string>& sources, const std::vector<std::string>& targets) const;
+		// Every stop reachable from the stop within max_time, the stop itself included, fastest first.
+		// The search is bounded by the budget and never looks farther
+		std::vector<ReachableStop> BuildReachableStops(const std::string& from, double max_time) const;
         
         std::pair<const graph::Edge<double>&, const transport_router::EdgeInfo&> GetFullEdgeInfo(graph::EdgeId edge_id) const;
 		
 		void SetGraph(graph::DirectedWeightedGraph<double> graph);
+		void SetGraph(graph::DirectedWeightedGraph<double> graph, RouterData router_data);
+		// Rebuilds the graph after buses or stops of the catalogue changed. The routing data of the
+		// previous graph is repaired where the mode allows it rather than computed from scratch.
+		// Removing buses shifts the indexes of the rest, so the names the buses had before are needed
+		void UpdateGraph(graph::DirectedWeightedGraph<double> previous_graph, RouterData previous_data
+			, const std::vector<std::string>& previous_bus_names);
+		// Switches the graph to other routing settings without building it anew. Weights are recomputed
+		// from the edges' distances, and the routing engine is customized for them: contraction
+		// hierarchies keep their vertex order, the all-pairs table is recomputed by Dijkstra searches
+		void SetRoutingMetric(int bus_wait_time, double bus_velocity);
+		// Takes bus_wait_time, bus_velocity and the walking settings from routing settings, a missing key keeps its value
+		void SetRoutingMetric(const json::Dict& routing_settings);
 		void SetBusWaitTime(int bus_wait_time);
 		void SetBusVelocity(double bus_velocity);
-		void SetStopnameToStopIdMap(std::map<std::string, graph::VertexId> stopname_to_stop_id);
-		void SetEdgeIdToInfoMap(std::map<graph::EdgeId, EdgeInfo> edge_id_to_info);
+		// Walking settings affect no graph edge and may change at any time
+		void SetWalkingVelocity(double walking_velocity);
+		void SetWalkingStopCount(size_t walking_stop_count);
+		void SetRoutingMode(RoutingMode routing_mode);
+		// Zero disables the cache
+		void SetRouteCacheCapacity(size_t route_cache_capacity);
+		void SetEdgeInfos(std::vector<EdgeInfo> edge_infos);
 
 		const graph::DirectedWeightedGraph<double>& GetGraph() const;
 		const int GetBusWaitTime() const;
 		const double GetBusVelocity() const;
-		const std::map<std::string, graph::VertexId>& GetStopnameToStopIdMap() const;
-		const std::map<graph::EdgeId, EdgeInfo>& GetEdgeIdToInfoMap() const;
+		double GetWalkingVelocity() const;
+		size_t GetWalkingStopCount() const;
+		RoutingMode GetRoutingMode() const;
+		size_t GetRouteCacheCapacity() const;
+		RouteCache::Stats GetRouteCacheStats() const;
+		const std::vector<EdgeInfo>& GetEdgeInfos() const;
+		// Name of the stop of a wait or of the bus of a ride
+		std::string_view GetEdgeName(const EdgeInfo& edge_info) const;
+		const AllPairsRouter::RoutesInternalData& GetRoutesInternalData() const;
+		const ContractionHierarchy::Hierarchy& GetContractionHierarchy() const;
 
 
 	private:
-
+		// Stop a route may start or end at and the minutes of walking between it and the route's endpoint
+		struct WalkingStop
+		{
+			uint32_t stop_id = 0;
+			double walk_time = 0;
+		};
+
+		// Route between one of the stops of the start and one of the stops of the end, walks not included
+		struct TransitRoute
+		{
+			size_t from_index = 0;
+			size_t to_index = 0;
+			RouteInfo route;
+		};
+
+		// Stop i has two vertices: 2i, where buses arrive, and 2i + 1, where they depart after the wait
+		static graph::VertexId GetArrivalVertex(uint32_t stop_id);
+		static graph::VertexId GetDepartureVertex(uint32_t stop_id);
+		// Arrival vertex of the stop, throws std::out_of_range for an unknown name
+		graph::VertexId GetStopVertex(std::string_view stop_name) const;
 		void MakeGraph();
-		void AddAllWaitEdges(const std::deque<Stop>& all_stops);
-		void AddBusEdges(const Bus& bus, std::vector<Stop*>::const_iterator begin, std::vector<Stop*>::const_iterator end);
-		void AddCircleBusEdges(const Bus& bus);
-		void AddLineBusEdges(const Bus& bus);
+		void MakeRouter();
+		size_t GetBuildThreadCount() const;
+		// Minutes a bus takes to cover the distance in meters
+		double ComputeRideTime(int distance) const;
+		double ComputeWalkTime(double distance) const;
+		// The stop itself with no walk, or the stops nearest to the point
+		std::vector<WalkingStop> FindWalkingStops(const RouteEndpoint& endpoint) const;
+		geo::Coordinates GetEndpointCoordinates(const RouteEndpoint& endpoint) const;
+		graph::GraphChange MatchPreviousEdges(const graph::DirectedWeightedGraph<double>& previous_graph
+			, const std::vector<EdgeInfo>& previous_edge_infos, const std::vector<std::string>& previous_bus_names) const;
+		static uint64_t MakeRouteCacheKey(graph::VertexId from_id, graph::VertexId to_id);
+		std::optional<RouteInfo> ComputeRoute(graph::VertexId from_id, graph::VertexId to_id) const;
+		// Fastest route counting the walks to the start stop and from the end stop
+		std::optional<TransitRoute> ComputeRoute(const std::vector<WalkingStop>& from_stops, const std::vector<WalkingStop>& to_stops) const;
+		std::optional<RouteInfo> MakeRouteInfo(const std::optional<RaptorRouter::Journey>& journey) const;
+		std::optional<RouteInfo> MakeRouteInfo(const std::optional<graph::RoutingEngine<double>::RouteInfo>& route) const;
+		graph::AStarRouter<double>::LowerBound MakeGeoLowerBound() const;
+		void AddAllWaitEdges(size_t stop_count);
+		// Rides between every two stops at positions [begin, end) of the route
+		void AddBusEdges(uint32_t bus_id, const Bus& bus, size_t begin, size_t end);
+		void AddCircleBusEdges(uint32_t bus_id, const Bus& bus);
+		void AddLineBusEdges(uint32_t bus_id, const Bus& bus);
 
 		const TransportCatalogue& tc_;
 
 		int bus_wait_time_;
 		double bus_velocity_;
+		double walking_velocity_ = DEFAULT_WALKING_VELOCITY;
+		size_t walking_stop_count_ = DEFAULT_WALKING_STOP_COUNT;
+		RoutingMode routing_mode_ = RoutingMode::ALL_PAIRS;
+		size_t build_thread_count_ = 0;
+		size_t route_cache_capacity_ = DEFAULT_ROUTE_CACHE_CAPACITY;
 
 		graph::DirectedWeightedGraph<double> graph_;
-		std::unique_ptr<graph::Router<double>> router_;
-		std::map<std::string, graph::VertexId> stopname_to_stop_id_;
-        std::map<graph::EdgeId, EdgeInfo> edge_id_to_info_;
+		std::unique_ptr<graph::RoutingEngine<double>> router_;
+		std::unique_ptr<RaptorRouter> raptor_router_;
+		// Answers depend only on the graph and the settings, so the cache lives as long as they do
+		std::unique_ptr<RouteCache> route_cache_ = std::make_unique<RouteCache>(DEFAULT_ROUTE_CACHE_CAPACITY);
+		std::vector<EdgeInfo> edge_infos_;
 	};
 }
\ No newline at end of file